@@ -0,0 +1,233 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "BinaryLogger.hpp"
+#include "os/TimeService.hpp"
+#include "os/CAS.hpp"
+
+#if defined(OROPKG_OS_GNULINUX) || defined(OROPKG_OS_XENOMAI) || defined(OROPKG_OS_LXRT) || defined(OROPKG_OS_MACOSX)
+# define ORO_BINARY_LOGGER_MMAP
+# include <sys/types.h>
+# include <sys/mman.h>
+# include <fcntl.h>
+# include <unistd.h>
+# include <pthread.h>
+# ifdef __linux__
+#  include <sys/syscall.h>
+# endif
+#endif
+
+namespace RTT
+{
+    using namespace std;
+
+    namespace {
+        /**
+         * The start of the file. The decoder relies on this layout.
+         */
+        struct FileHeader {
+            char magic[8];
+            boost::uint32_t version;
+            boost::uint32_t header_size;
+            boost::uint32_t capacity;
+            boost::uint32_t record_header_size;
+            //! The time the file was created, in nanoseconds.
+            boost::int64_t reference;
+            char reserved[32];
+        };
+
+        /**
+         * Precedes each record. Records are aligned at 8 bytes and
+         * follow each other until a record with size zero.
+         */
+        struct RecordHeader {
+            //! The size of the record, including this header.
+            boost::uint32_t size;
+            //! Set to one when the record is complete.
+            volatile boost::uint32_t committed;
+            //! The time the record was made, in nanoseconds.
+            boost::int64_t time;
+            boost::uint32_t thread;
+            //! 1 for a format definition, 2 for a message.
+            boost::uint8_t type;
+            boost::uint8_t nargs;
+            boost::uint16_t id;
+        };
+
+        unsigned int threadId()
+        {
+#if defined(ORO_BINARY_LOGGER_MMAP) && defined(__linux__)
+            static __thread unsigned int tid = 0;
+            if ( tid == 0 )
+                tid = syscall(SYS_gettid);
+            return tid;
+#elif defined(ORO_BINARY_LOGGER_MMAP)
+            return (unsigned int)(unsigned long)pthread_self();
+#else
+            return 0;
+#endif
+        }
+
+        boost::int64_t now()
+        {
+            return os::TimeService::ticks2nsecs( os::TimeService::Instance()->getTicks() );
+        }
+    }
+
+    struct BinaryLogger::D
+    {
+        D() : fd(-1), base(0), capacity(0), used(0), nextid(0) {
+            oro_atomic_set(&dropped, 0);
+        }
+        int fd;
+        char* base;
+        unsigned int capacity;
+        volatile unsigned int used;
+        volatile unsigned int nextid;
+        oro_atomic_t dropped;
+    };
+
+    BinaryLogger::BinaryLogger(const std::string& filename, unsigned int size)
+        : d( new D() )
+    {
+#ifdef ORO_BINARY_LOGGER_MMAP
+        Logger::In in("BinaryLogger");
+        if ( size < sizeof(FileHeader) + sizeof(RecordHeader) ) {
+            RTT::log(Error) << "Size of " << size << " bytes is too small for binary log file " << filename << endlog();
+            return;
+        }
+        d->fd = open( filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+        if ( d->fd < 0 || ftruncate( d->fd, size ) != 0 ) {
+            RTT::log(Error) << "Could not create binary log file " << filename << endlog();
+            return;
+        }
+        void* m = mmap( 0, size, PROT_READ | PROT_WRITE, MAP_SHARED, d->fd, 0 );
+        if ( m == MAP_FAILED ) {
+            RTT::log(Error) << "Could not map binary log file " << filename << " in memory." << endlog();
+            return;
+        }
+        d->base = static_cast<char*>(m);
+        d->capacity = size;
+        FileHeader* h = reinterpret_cast<FileHeader*>(d->base);
+        memcpy( h->magic, "RTTBLOG", 8 );
+        h->version = 1;
+        h->header_size = sizeof(FileHeader);
+        h->capacity = size;
+        h->record_header_size = sizeof(RecordHeader);
+        h->reference = now();
+        d->used = sizeof(FileHeader);
+#else
+        RTT::log(Error) << "BinaryLogger is not supported on this target." << endlog();
+#endif
+    }
+
+    BinaryLogger::~BinaryLogger()
+    {
+#ifdef ORO_BINARY_LOGGER_MMAP
+        if ( d->base ) {
+            munmap( d->base, d->capacity );
+            // only keep what was written.
+            if ( ftruncate( d->fd, d->used ) != 0 )
+                RTT::log(Warning) << "Could not truncate binary log file." << endlog();
+        }
+        if ( d->fd >= 0 )
+            close( d->fd );
+#endif
+        delete d;
+    }
+
+    bool BinaryLogger::ready() const
+    {
+        return d->base != 0;
+    }
+
+    unsigned int BinaryLogger::getDropped() const
+    {
+        return oro_atomic_read( &d->dropped );
+    }
+
+    unsigned int BinaryLogger::getUsed() const
+    {
+        return d->used;
+    }
+
+    unsigned int BinaryLogger::addFormat(const char* format, Logger::LogLevel level)
+    {
+        unsigned int id;
+        do {
+            id = d->nextid;
+            if ( id == 0xffff )
+                return 0;
+        } while ( !os::CAS( &d->nextid, id, id + 1 ) );
+        ++id;
+        unsigned int len = strlen(format) + 1;
+        char* p = begin( id, 0, 1 + len, 1 );
+        if ( p == 0 )
+            return 0;
+        *p = char(level);
+        memcpy( p + 1, format, len );
+        commit( p );
+        return id;
+    }
+
+    char* BinaryLogger::begin(unsigned int id, unsigned int nargs, unsigned int payload, int type)
+    {
+        if ( d->base == 0 )
+            return 0;
+        unsigned int size = ( sizeof(RecordHeader) + payload + 7 ) & ~7u;
+        unsigned int offset;
+        do {
+            offset = d->used;
+            if ( size > d->capacity - offset ) {
+                oro_atomic_inc( &d->dropped );
+                return 0;
+            }
+        } while ( !os::CAS( &d->used, offset, offset + size ) );
+
+        RecordHeader* h = reinterpret_cast<RecordHeader*>( d->base + offset );
+        // the size first, such that the decoder can skip this record
+        // if it is never committed.
+        h->size = size;
+        h->time = now();
+        h->thread = threadId();
+        h->type = type;
+        h->nargs = nargs;
+        h->id = id;
+        return d->base + offset + sizeof(RecordHeader);
+    }
+
+    bool BinaryLogger::commit(char* p)
+    {
+        if ( p == 0 )
+            return false;
+        RecordHeader* h = reinterpret_cast<RecordHeader*>( p - sizeof(RecordHeader) );
+        // also a memory barrier: the record is complete before it is marked so.
+        os::CAS( &h->committed, 0u, 1u );
+        return true;
+    }
+}
@@ -0,0 +1,271 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef ORO_BINARY_LOGGER_HPP
+#define ORO_BINARY_LOGGER_HPP
+
+#include "rtt-config.h"
+#include "Logger.hpp"
+#include "os/oro_arch.h"
+#include <boost/cstdint.hpp>
+#include <string>
+#include <cstring>
+
+namespace RTT
+{
+    /**
+     * A logger for high-rate diagnostics, which writes compact binary
+     * records to a memory-mapped file instead of formatting text.
+     *
+     * A format string is registered once with addFormat(), which returns
+     * its ID. A log() call then only stores the ID, a time stamp from
+     * os::TimeService, the ID of the calling thread and the typed
+     * arguments. Turning the records back into text is left to the
+     * decoder in tools/scripts/rtt-binlog-decode.py, which substitutes the
+     * arguments in the printf-style format string:
+     * @verbatim
+     BinaryLogger blog("diagnostics.rtb");
+     unsigned int cycle_fmt = blog.addFormat("cycle %d took %f s", Logger::Debug);
+     ...
+     blog.log(cycle_fmt, cycle, duration);
+     @endverbatim
+     *
+     * log() is lock-free and does not allocate, so it may be used from
+     * real-time threads and from multiple threads at once. The file
+     * has a fixed size. Once it is full, records are dropped and counted,
+     * see getDropped(). Since the file is mapped, the records written
+     * so far survive a crash of the process.
+     *
+     * Arguments can be of any integer or floating point type, a C string
+     * or a std::string. Strings are truncated to 65535 characters. At
+     * most six arguments can be logged per record.
+     *
+     * The BinaryLogger is only available on POSIX targets. On other
+     * targets, ready() returns false and nothing is logged.
+     * @ingroup CoreLib
+     */
+    class RTT_API BinaryLogger
+    {
+    public:
+        /**
+         * Creates (or truncates) \a filename and maps it in memory.
+         * @param filename The file to write to.
+         * @param size The size of the file in bytes. Records which do not
+         * fit anymore are dropped.
+         */
+        BinaryLogger(const std::string& filename, unsigned int size = 16*1024*1024);
+
+        /**
+         * Unmaps and closes the file. No thread may be logging anymore.
+         */
+        ~BinaryLogger();
+
+        /**
+         * Returns true if the file could be created and mapped.
+         */
+        bool ready() const;
+
+        /**
+         * Registers a printf-style format string.
+         * @param format The format string, for example "%s moved to %f".
+         * @param level The LoggerLevel the decoder shows for messages of this
+         * format.
+         * @return The ID to pass to log(), or zero if the file is full.
+         */
+        unsigned int addFormat(const char* format, Logger::LogLevel level = Logger::Info);
+
+        /**
+         * Returns the number of records which were dropped because
+         * the file was full.
+         */
+        unsigned int getDropped() const;
+
+        /**
+         * Returns the number of bytes written to the file.
+         */
+        unsigned int getUsed() const;
+
+        /**
+         * Logs a message with format \a id and the given arguments.
+         * @return false if the record was dropped.
+         */
+        bool log(unsigned int id)
+        {
+            return commit( begin(id, 0, 0) );
+        }
+
+        template<class A1>
+        bool log(unsigned int id, const A1& a1)
+        {
+            char* p = begin(id, 1, encode(0, a1));
+            if (p == 0)
+                return false;
+            encode(p, a1);
+            return commit(p);
+        }
+
+        template<class A1, class A2>
+        bool log(unsigned int id, const A1& a1, const A2& a2)
+        {
+            char* p = begin(id, 2, encode(0, a1) + encode(0, a2));
+            if (p == 0)
+                return false;
+            char* c = p;
+            c += encode(c, a1);
+            encode(c, a2);
+            return commit(p);
+        }
+
+        template<class A1, class A2, class A3>
+        bool log(unsigned int id, const A1& a1, const A2& a2, const A3& a3)
+        {
+            char* p = begin(id, 3, encode(0, a1) + encode(0, a2) + encode(0, a3));
+            if (p == 0)
+                return false;
+            char* c = p;
+            c += encode(c, a1);
+            c += encode(c, a2);
+            encode(c, a3);
+            return commit(p);
+        }
+
+        template<class A1, class A2, class A3, class A4>
+        bool log(unsigned int id, const A1& a1, const A2& a2, const A3& a3, const A4& a4)
+        {
+            char* p = begin(id, 4, encode(0, a1) + encode(0, a2) + encode(0, a3) + encode(0, a4));
+            if (p == 0)
+                return false;
+            char* c = p;
+            c += encode(c, a1);
+            c += encode(c, a2);
+            c += encode(c, a3);
+            encode(c, a4);
+            return commit(p);
+        }
+
+        template<class A1, class A2, class A3, class A4, class A5>
+        bool log(unsigned int id, const A1& a1, const A2& a2, const A3& a3, const A4& a4, const A5& a5)
+        {
+            char* p = begin(id, 5, encode(0, a1) + encode(0, a2) + encode(0, a3) + encode(0, a4) + encode(0, a5));
+            if (p == 0)
+                return false;
+            char* c = p;
+            c += encode(c, a1);
+            c += encode(c, a2);
+            c += encode(c, a3);
+            c += encode(c, a4);
+            encode(c, a5);
+            return commit(p);
+        }
+
+        template<class A1, class A2, class A3, class A4, class A5, class A6>
+        bool log(unsigned int id, const A1& a1, const A2& a2, const A3& a3, const A4& a4, const A5& a5, const A6& a6)
+        {
+            char* p = begin(id, 6, encode(0, a1) + encode(0, a2) + encode(0, a3) + encode(0, a4) + encode(0, a5) + encode(0, a6));
+            if (p == 0)
+                return false;
+            char* c = p;
+            c += encode(c, a1);
+            c += encode(c, a2);
+            c += encode(c, a3);
+            c += encode(c, a4);
+            c += encode(c, a5);
+            encode(c, a6);
+            return commit(p);
+        }
+
+    private:
+        BinaryLogger(const BinaryLogger&);
+        BinaryLogger& operator=(const BinaryLogger&);
+
+        /**
+         * Reserves a record with \a payload bytes of arguments.
+         * @param type 2 for a message, 1 for a format definition.
+         * @return The start of the payload, or null if the file is full.
+         */
+        char* begin(unsigned int id, unsigned int nargs, unsigned int payload, int type = 2);
+
+        /**
+         * Marks the record of which the payload starts at \a p as
+         * complete, such that the decoder shows it.
+         * @return false if \a p is null.
+         */
+        bool commit(char* p);
+
+        /**
+         * Each encode() function writes one argument to \a p, unless \a p
+         * is null, and returns the number of bytes it takes. An argument
+         * is a type tag followed by the value: 'i' for a signed and 'u' for
+         * an unsigned 64 bit integer, 'd' for a double and 's' for a string,
+         * which is a 16 bit length followed by the characters.
+         */
+        static unsigned int encodeSigned(char* p, boost::int64_t v)
+        {
+            if (p) { *p = 'i'; std::memcpy(p + 1, &v, sizeof(v)); }
+            return 1 + sizeof(v);
+        }
+        static unsigned int encodeUnsigned(char* p, boost::uint64_t v)
+        {
+            if (p) { *p = 'u'; std::memcpy(p + 1, &v, sizeof(v)); }
+            return 1 + sizeof(v);
+        }
+        static unsigned int encodeDouble(char* p, double v)
+        {
+            if (p) { *p = 'd'; std::memcpy(p + 1, &v, sizeof(v)); }
+            return 1 + sizeof(v);
+        }
+        static unsigned int encodeString(char* p, const char* s, std::size_t len)
+        {
+            boost::uint16_t l = len > 0xffff ? 0xffff : boost::uint16_t(len);
+            if (p) { *p = 's'; std::memcpy(p + 1, &l, sizeof(l)); std::memcpy(p + 1 + sizeof(l), s, l); }
+            return 1 + sizeof(l) + l;
+        }
+
+        static unsigned int encode(char* p, bool v) { return encodeUnsigned(p, v); }
+        static unsigned int encode(char* p, char v) { return encodeSigned(p, v); }
+        static unsigned int encode(char* p, signed char v) { return encodeSigned(p, v); }
+        static unsigned int encode(char* p, unsigned char v) { return encodeUnsigned(p, v); }
+        static unsigned int encode(char* p, short v) { return encodeSigned(p, v); }
+        static unsigned int encode(char* p, unsigned short v) { return encodeUnsigned(p, v); }
+        static unsigned int encode(char* p, int v) { return encodeSigned(p, v); }
+        static unsigned int encode(char* p, unsigned int v) { return encodeUnsigned(p, v); }
+        static unsigned int encode(char* p, long v) { return encodeSigned(p, v); }
+        static unsigned int encode(char* p, unsigned long v) { return encodeUnsigned(p, v); }
+        static unsigned int encode(char* p, long long v) { return encodeSigned(p, v); }
+        static unsigned int encode(char* p, unsigned long long v) { return encodeUnsigned(p, v); }
+        static unsigned int encode(char* p, float v) { return encodeDouble(p, v); }
+        static unsigned int encode(char* p, double v) { return encodeDouble(p, v); }
+        static unsigned int encode(char* p, const char* v) { return encodeString(p, v, std::strlen(v)); }
+        static unsigned int encode(char* p, const std::string& v) { return encodeString(p, v.c_str(), v.length()); }
+
+        struct D;
+        D* d;
+    };
+}
+
+#endif
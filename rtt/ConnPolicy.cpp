@@ -46,6 +46,8 @@
 #include "ConnPolicy.hpp"
 #include "Property.hpp"
 #include "PropertyBag.hpp"
+#include "os/threads.hpp"
+#include "os/fosi.h"
 
 using namespace std;
 
@@ -78,7 +80,8 @@ namespace RTT
     }
 
     ConnPolicy::ConnPolicy(int type /* = DATA*/, int lock_policy /*= LOCK_FREE*/)
-        : type(type), init(false), lock_policy(lock_policy), pull(false), size(0), transport(0), data_size(0) {}
+        : type(type), init(false), lock_policy(lock_policy), pull(false), size(0), transport(0), data_size(0),
+          dispatcher_scheduler(ORO_SCHED_RT), dispatcher_priority(os::HighestPriority), dispatcher_cpu_affinity(0) {}
 
     /** @cond */
     /** This is dead code. We use the boost::serialization now.
@@ -86,6 +86,9 @@ namespace RTT {
      *       the name contains a port number or file descriptor to be opened.
      *       You only need to provide a name_id if you're using out-of-band transports
      *       without supervisor, for example, when using MQueues without Corba.
+     *  <li> the scheduler, priority and cpu affinity of the thread which receives
+     *       the data of this connection, for transports which use such a thread.
+     *       Connections with the same settings share the same thread.
      * </ul>
      * @ingroup Ports
      */
@@ -180,6 +183,26 @@ namespace RTT {
          * work around name clashes or if the transport protocol documents to do so.
          */
         mutable std::string name_id;
+
+        /**
+         * The scheduler of the thread which receives the data of this
+         * connection, for transports which use such a thread, like the
+         * mqueue transport. Defaults to ORO_SCHED_RT.
+         */
+        int    dispatcher_scheduler;
+
+        /**
+         * The priority of the thread which receives the data of this
+         * connection. Defaults to os::HighestPriority.
+         */
+        int    dispatcher_priority;
+
+        /**
+         * The cpu affinity mask of the thread which receives the data
+         * of this connection. Defaults to zero, which does not restrict
+         * the thread to any cpu.
+         */
+        unsigned int dispatcher_cpu_affinity;
     };
 }
 
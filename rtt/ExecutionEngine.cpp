@@ -42,6 +42,7 @@
 #include "base/TaskCore.hpp"
 #include "rtt-fwd.hpp"
 #include "os/MutexLock.hpp"
+#include "os/TimeService.hpp"
 #include "internal/MWSRQueue.hpp"
 #include "TaskContext.hpp"
 #include "internal/CatchConfig.hpp"
@@ -51,6 +52,7 @@
 #include <algorithm>
 
 #define ORONUM_EE_MQUEUE_SIZE 100
+#define ORONUM_EE_LOW_MESSAGES_PER_STEP 10
 
 namespace RTT
 {
@@ -67,10 +69,15 @@ namespace RTT
 
     ExecutionEngine::ExecutionEngine( TaskCore* owner )
         : taskc(owner),
-          mqueue(new MWSRQueue<DisposableInterface*>(ORONUM_EE_MQUEUE_SIZE) ),
           f_queue( new MWSRQueue<ExecutableInterface*>(ORONUM_EE_MQUEUE_SIZE) ),
-          mmaster(0)
+          mmaster(0),
+          mstep_budget(0), mstep_deadline(0), mstep_overruns(0)
     {
+        for (int lane = HighPriority; lane <= LowPriority; ++lane) {
+            mqueues[lane] = new MWSRQueue<DisposableInterface*>(ORONUM_EE_MQUEUE_SIZE);
+            mlane_budget[lane] = 0;
+        }
+        mlane_budget[LowPriority] = ORONUM_EE_LOW_MESSAGES_PER_STEP;
     }
 
     ExecutionEngine::~ExecutionEngine()
@@ -89,11 +96,13 @@ namespace RTT
             foo->unloaded();
 
         DisposableInterface* dis;
-        while ( mqueue->dequeue( dis ) )
-            dis->dispose();
+        for (int lane = HighPriority; lane <= LowPriority; ++lane) {
+            while ( mqueues[lane]->dequeue( dis ) )
+                dis->dispose();
+            delete mqueues[lane];
+        }
 
         delete f_queue;
-        delete mqueue;
     }
 
     TaskCore* ExecutionEngine::getParent() {
@@ -126,9 +135,36 @@ namespace RTT
             }
             if ( --nbr == 0) // we did a round-trip
                 break;
+            // the others are first in line in the next step.
+            if ( budgetSpent() ) {
+                if ( this->getActivity() )
+                    this->getActivity()->trigger();
+                break;
+            }
         }
     }
 
+    void ExecutionEngine::setStepBudget(Seconds budget)
+    {
+        mstep_budget = Seconds_to_nsecs(budget);
+        mstep_overruns = 0;
+    }
+
+    Seconds ExecutionEngine::getStepBudget() const
+    {
+        return nsecs_to_Seconds(mstep_budget);
+    }
+
+    unsigned int ExecutionEngine::getStepOverruns() const
+    {
+        return mstep_overruns;
+    }
+
+    bool ExecutionEngine::budgetSpent() const
+    {
+        return mstep_deadline != 0 && os::TimeService::Instance()->getNSecs() >= mstep_deadline;
+    }
+
     bool ExecutionEngine::runFunction( ExecutableInterface* f )
     {
         if (this->getActivity() && f) {
@@ -211,19 +247,45 @@ namespace RTT
 
     bool ExecutionEngine::hasWork()
     {
-        return !mqueue->isEmpty();
+        for (int lane = HighPriority; lane <= LowPriority; ++lane)
+            if ( !mqueues[lane]->isEmpty() )
+                return true;
+        return false;
+    }
+
+    void ExecutionEngine::setMessageLaneBudget(MessagePriority lane, unsigned int max)
+    {
+        mlane_budget[lane] = max;
+    }
+
+    unsigned int ExecutionEngine::getMessageLaneBudget(MessagePriority lane) const
+    {
+        return mlane_budget[lane];
     }
 
     void ExecutionEngine::processMessages()
     {
-        // execute all commands from the AtomicQueue.
+        // execute all commands from the AtomicQueues, highest lane first.
         // msg_lock may not be held when entering this function !
         DisposableInterface* com(0);
         {
-            while ( mqueue->dequeue(com) ) {
-                assert( com );
-                com->executeAndDispose();
+            unsigned int done[LowPriority + 1] = { 0 };
+            int lane = HighPriority;
+            while ( lane <= LowPriority ) {
+                if ( (mlane_budget[lane] == 0 || done[lane] < mlane_budget[lane]) && mqueues[lane]->dequeue(com) ) {
+                    assert( com );
+                    com->executeAndDispose();
+                    ++done[lane];
+                    if ( budgetSpent() )
+                        break;
+                    // a higher priority message may have arrived in the mean time.
+                    lane = HighPriority;
+                } else
+                    ++lane;
             }
+            // a bounded lane or the step budget left work: make sure we get a next step.
+            if ( this->getActivity() && ExecutionEngine::hasWork() )
+                this->getActivity()->trigger();
             // there's no need to hold the lock during
             // emptying the queue. But we must hold the
             // lock once between excuteAndDispose and the
@@ -237,10 +299,23 @@ namespace RTT
     }
 
     bool ExecutionEngine::process( DisposableInterface* c )
+    {
+        return enqueueMessage( c, NormalPriority );
+    }
+
+    bool ExecutionEngine::process( DisposableInterface* c, MessagePriority prio )
+    {
+        // keep subclasses which only override process(c) working.
+        if ( prio == NormalPriority )
+            return this->process( c );
+        return enqueueMessage( c, prio );
+    }
+
+    bool ExecutionEngine::enqueueMessage( DisposableInterface* c, MessagePriority prio )
     {
         // forward message to master ExecutionEngine if available
         if (mmaster) {
-            return mmaster->process(c);
+            return mmaster->process(c, prio);
         }
 
         if ( c && this->getActivity() ) {
@@ -248,7 +323,7 @@ namespace RTT
             if (taskc && taskc->mTaskState == TaskCore::FatalError )
                 return false;
 
-            bool result = mqueue->enqueue( c );
+            bool result = mqueues[prio]->enqueue( c );
             this->getActivity()->trigger();
             msg_cond.broadcast(); // required for waitAndProcessMessages() (EE thread)
             return result;
@@ -318,7 +393,9 @@ namespace RTT
                 // We must lock because the cond variable will unlock msg_lock.
                 os::MutexLock lock(msg_lock);
                 if (!pred()) {
-                    msg_cond.wait(msg_lock); // now processMessages may run.
+                    // a bounded lane may still hold the message we're waiting for.
+                    if ( !ExecutionEngine::hasWork() )
+                        msg_cond.wait(msg_lock); // now processMessages may run.
                 } else {
                     return; // do not process messages when pred() == true;
                 }
@@ -345,9 +422,21 @@ namespace RTT
     }
 
     void ExecutionEngine::step() {
+        if ( mstep_budget == 0 ) {
+            processMessages();
+            processFunctions();
+            processChildren(); // aren't these ExecutableInterfaces ie functions ?
+            return;
+        }
+        // messages and functions yield to the updateHook() when the budget is spent.
+        os::TimeService::nsecs start = os::TimeService::Instance()->getNSecs();
+        mstep_deadline = start + mstep_budget;
         processMessages();
         processFunctions();
-        processChildren(); // aren't these ExecutableInterfaces ie functions ?
+        mstep_deadline = 0;
+        processChildren();
+        if ( os::TimeService::Instance()->getNSecs() - start > mstep_budget )
+            ++mstep_overruns;
     }
 
     void ExecutionEngine::processChildren() {
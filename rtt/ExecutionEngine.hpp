@@ -42,10 +42,12 @@
 #include "os/Mutex.hpp"
 #include "os/MutexLock.hpp"
 #include "os/Condition.hpp"
+#include "os/Time.hpp"
 #include "base/RunnableInterface.hpp"
 #include "base/ActivityInterface.hpp"
 #include "base/DisposableInterface.hpp"
 #include "base/ExecutableInterface.hpp"
+#include "MessagePriority.hpp"
 #include "internal/List.hpp"
 #include <vector>
 #include <boost/function.hpp>
@@ -121,6 +123,61 @@ namespace RTT
          */
         virtual bool process(base::DisposableInterface* c);
 
+        /**
+         * Queue and execute (process) a given message in the lane
+         * of priority \a prio. Messages in a higher priority lane are
+         * always executed before those in lower priority lanes.
+         *
+         * \a NormalPriority messages are passed on to process(base::DisposableInterface*),
+         * such that subclasses which only override that function still see all
+         * messages of operations without a priority. Subclasses which must also
+         * see the \a HighPriority and \a LowPriority messages override this
+         * function as well.
+         *
+         * @return true if the message got accepted, false otherwise.
+         * @see setMessageLaneBudget
+         */
+        virtual bool process(base::DisposableInterface* c, MessagePriority prio);
+
+        /**
+         * Limit the number of messages of a given lane that are
+         * executed in a single step(). Remaining messages are executed
+         * in the next step(). By default, only the \a LowPriority lane
+         * is bounded.
+         * @param lane The lane to limit.
+         * @param max The maximum number of messages processed per step,
+         * or zero for no limit.
+         */
+        void setMessageLaneBudget(MessagePriority lane, unsigned int max);
+
+        /**
+         * Returns the maximum number of messages of \a lane that are
+         * executed in a single step(), zero if unbounded.
+         */
+        unsigned int getMessageLaneBudget(MessagePriority lane) const;
+
+        /**
+         * Limit the time spent in a single step() on processing messages
+         * and functions (programs and state machines). When the budget
+         * is spent, the remaining messages and functions are deferred
+         * to the next step(). At least one message and one function are
+         * executed in each step, and the updateHook() of the owner and its
+         * children is always executed.
+         * @param budget The maximum time per step, or zero to disable the budget.
+         */
+        void setStepBudget(Seconds budget);
+
+        /**
+         * Returns the time budget of a single step(), zero if disabled.
+         */
+        Seconds getStepBudget() const;
+
+        /**
+         * Returns the number of step()s that exceeded the step budget
+         * since this engine was created or the budget was last set.
+         */
+        unsigned int getStepOverruns() const;
+
         /**
          * Run a given function in step() or loop(). The function may only
          * be destroyed after the
@@ -249,9 +306,14 @@ namespace RTT
         base::TaskCore*     taskc;
 
         /**
-         * Our Message queue
+         * Our Message queues, one for each MessagePriority lane.
+         */
+        internal::MWSRQueue<base::DisposableInterface*>* mqueues[LowPriority + 1];
+
+        /**
+         * The maximum number of messages processed per step, for each lane.
          */
-        internal::MWSRQueue<base::DisposableInterface*>* mqueue;
+        unsigned int mlane_budget[LowPriority + 1];
 
         std::vector<base::TaskCore*> children;
 
@@ -269,7 +331,24 @@ namespace RTT
          */
         ExecutionEngine *mmaster;
 
+        /**
+         * The time budget of a single step and the absolute
+         * time at which the current step's budget is spent, in nanoseconds.
+         * The deadline is zero outside step().
+         */
+        nsecs mstep_budget, mstep_deadline;
+        unsigned int mstep_overruns;
+
+        /**
+         * Returns true if the time budget of the current step() is spent.
+         */
+        bool budgetSpent() const;
+
         void processMessages();
+        /**
+         * Puts \a c in the message lane \a prio, or forwards it to the master.
+         */
+        bool enqueueMessage(base::DisposableInterface* c, MessagePriority prio);
         void processFunctions();
         void processChildren();
 
@@ -56,15 +56,28 @@
 #    include <log4cpp/Category.hh>
 #   endif
 #  endif
-#  ifdef OROSEM_REMOTE_LOGGING
-#   include "base/BufferLockFree.hpp"
-#  endif
 #endif
 
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
 #include "rtt-config.h"
 #include "rtt-fwd.hpp"
 
+#ifndef OROBLD_DISABLE_LOGGING
+# include "base/BufferLockFree.hpp"
+# include "os/Thread.hpp"
+# include "os/threads.hpp"
+# include "os/oro_arch.h"
+# include "os/CAS.hpp"
+# if defined(OROPKG_OS_GNULINUX) || defined(OROPKG_OS_XENOMAI) || defined(OROPKG_OS_LXRT) || defined(OROPKG_OS_MACOSX)
+#  define ORO_LOGGER_CRASH_FLUSH
+#  define ORO_LOGGER_THREAD_BUFFERS
+#  include <signal.h>
+#  include <pthread.h>
+# endif
+#endif
+
 namespace RTT
 {
     using namespace std;
@@ -128,6 +141,9 @@ namespace RTT
     struct Logger::D
     {
     public:
+        struct ModuleSettings;
+        struct ThreadLog;
+
         D(std::ostream& str, char const* logfile_name) :
 #ifndef OROSEM_PRINTF_LOGGING
               stdoutput( &str ),
@@ -147,13 +163,31 @@ namespace RTT
               timestamp(0),
               started(false), showtime(true), allowRT(false),
               mlogStdOut(true), mlogFile(true),
-              moduleptr("Logger")
+              nmodules(0), scope(0),
+              async(false), generation(0), shared(0), reported(0), drainer(0), linestate(LineEmpty)
         {
+            oro_atomic_set(&overflows, 0);
+            for (unsigned int i = 0; i != MaxThreads; ++i)
+                threads[i] = 0;
+            setModule("Logger");
 #if defined(OROSEM_FILE_LOGGING) && !defined(OROSEM_LOG4CPP_LOGGING) && defined(OROSEM_PRINTF_LOGGING)
             logfile = fopen(logfile_name ? logfile_name : "orocos.log","w");
+#endif
+#ifdef ORO_LOGGER_THREAD_BUFFERS
+            pthread_key_create(&threadkey, &D::released);
 #endif
         }
 
+        ~D()
+        {
+#ifdef ORO_LOGGER_THREAD_BUFFERS
+            pthread_key_delete(threadkey);
+#endif
+            for (unsigned int i = 0; i != MaxThreads; ++i)
+                delete threads[i];
+            delete shared;
+        }
+
         bool maylog() const {
             if (!started || (outloglevel == RealTime && allowRT == false))
                 return false;
@@ -161,57 +195,662 @@ namespace RTT
         }
 
         bool maylogStdOut() const {
-            if ( inloglevel <= outloglevel && outloglevel != Never && inloglevel != Never && mlogStdOut)
+            ThreadLog* t = const_cast<D*>(this)->self();
+            return t ? maylogStdOut(t->level, t->scope) : maylogStdOut(inloglevel, scope);
+        }
+
+        bool maylogStdOut(LogLevel ll, ModuleSettings* s) const {
+            LogLevel out = ( s && s->level >= 0 ) ? LogLevel(s->level) : outloglevel;
+            if ( ll <= out && out != Never && ll != Never && mlogStdOut)
                 return true;
             return false;
         }
 
         bool maylogFile() const {
-            if ( (inloglevel <= Info || inloglevel <= outloglevel)  && mlogFile)
+            ThreadLog* t = const_cast<D*>(this)->self();
+            return t ? maylogFile(t->level, t->scope) : maylogFile(inloglevel, scope);
+        }
+
+        bool maylogFile(LogLevel ll, ModuleSettings* s) const {
+            // a module's own level also applies to the log file.
+            if ( s && s->level >= 0 )
+                return ll <= s->level && ll != Never && mlogFile;
+            if ( (ll <= Info || ll <= outloglevel)  && mlogFile)
                 return true;
             return false;
         }
 
+        /**
+         * The log level and rate limit of a module. Entries are never
+         * removed, such that they can be read without locking.
+         */
+        struct ModuleSettings {
+            char name[ModuleNameSize];
+            //! The output log level of this module, or -1 to use the global one.
+            int level;
+            //! The number of lines per second, or zero if not rate limited.
+            unsigned int rate;
+            unsigned int burst;
+            volatile int tokens;
+            //! When tokens were last added, in ms since the reference time.
+            volatile unsigned int refilled;
+            oro_atomic_t suppressed;
+            //! The suppressed count and time (in ms) of the last report. Drain thread only.
+            int reported;
+            unsigned int reportedat;
+        };
+
+        /**
+         * Whether the line that is being composed may be logged. This is
+         * decided by the rate limit when its first text is added, such
+         * that the text of a suppressed line is never formatted.
+         */
+        enum LineState { LineEmpty, LineAdmitted, LineDropped };
+
+        enum { MaxModules = 32 };
+
+        /**
+         * Returns the number of milliseconds since the reference time.
+         */
+        unsigned int millis() const {
+            return (unsigned int)( TimeService::ticks2nsecs( TimeService::Instance()->getTicks() - timestamp ) / 1000000 );
+        }
+
+        /**
+         * Returns the settings of module \a name, or null if it has none.
+         * Does not lock.
+         */
+        ModuleSettings* find(const char* name) const {
+            unsigned int n = nmodules;
+            for (unsigned int i = 0; i != n; ++i)
+                if ( strcmp( modules[i].name, name ) == 0 )
+                    return const_cast<ModuleSettings*>( &modules[i] );
+            return 0;
+        }
+
+        /**
+         * Returns the settings of module \a name, which are added if
+         * they did not exist yet. Returns null if there are too many
+         * modules with settings. inpguard must be held.
+         */
+        ModuleSettings* settings(const char* name) {
+            ModuleSettings* s = find(name);
+            if ( s || nmodules == MaxModules )
+                return s;
+            s = &modules[nmodules];
+            strncpy( s->name, name, ModuleNameSize - 1 );
+            s->name[ModuleNameSize - 1] = 0;
+            s->level = -1;
+            s->rate = 0;
+            s->burst = 0;
+            s->tokens = 0;
+            s->refilled = 0;
+            oro_atomic_set( &s->suppressed, 0 );
+            s->reported = 0;
+            s->reportedat = millis() - 1000;
+            // publish the entry after it was filled in.
+            unsigned int n = nmodules;
+            os::CAS( &nmodules, n, n + 1 );
+            if ( strcmp( module, s->name ) == 0 )
+                scope = s;
+            for (unsigned int i = 0; i != MaxThreads; ++i)
+                if ( threads[i] && strcmp( threads[i]->module, s->name ) == 0 )
+                    threads[i]->scope = s;
+            return s;
+        }
+
+        /**
+         * Adds the tokens that were earned since the last refill.
+         * Lock-free.
+         */
+        void refill(ModuleSettings* s) {
+            unsigned int now = millis();
+            unsigned int last = s->refilled;
+            unsigned long long earned = (unsigned long long)(now - last) * s->rate / 1000;
+            if ( earned == 0 )
+                return;
+            if ( earned > s->burst )
+                earned = s->burst;
+            // only the thread which advances the refill time adds tokens.
+            if ( !os::CAS( &s->refilled, last, now ) )
+                return;
+            int t, n;
+            do {
+                t = s->tokens;
+                n = t + int(earned) > int(s->burst) ? int(s->burst) : t + int(earned);
+            } while ( !os::CAS( &s->tokens, t, n ) );
+        }
+
+        /**
+         * Takes a token from the bucket of module \a s. Lock-free.
+         * @return false if the line must be suppressed.
+         */
+        bool take(ModuleSettings* s) {
+            refill(s);
+            int t;
+            do {
+                t = s->tokens;
+                if ( t <= 0 ) {
+                    oro_atomic_inc( &s->suppressed );
+                    return false;
+                }
+            } while ( !os::CAS( &s->tokens, t, t - 1 ) );
+            return true;
+        }
+
+        /**
+         * Returns true if module \a s could take a token now.
+         * Changes nothing, so a query does not count as a suppressed line.
+         */
+        bool available(ModuleSettings* s) const {
+            unsigned long long earned = (unsigned long long)(millis() - s->refilled) * s->rate / 1000;
+            return s->tokens > 0 || earned > 0;
+        }
+
+        /**
+         * Decides whether the line in state \a state, in module \a s,
+         * may be logged. The first call for a line takes a token of a
+         * rate limited module, or counts the line as suppressed.
+         * Lock-free, but the shared line needs inpguard.
+         */
+        bool admit(int& state, ModuleSettings* s) {
+            if ( state == LineEmpty )
+                state = ( s == 0 || s->rate == 0 || take(s) ) ? LineAdmitted : LineDropped;
+            return state == LineAdmitted;
+        }
+
+        /**
+         * Logs how many lines were suppressed by rate limits, for each
+         * module at most once per second. Called by the drain thread with
+         * outguard held.
+         * @return true if a report was written.
+         */
+        bool reportSuppressed() {
+            bool written = false;
+            unsigned int n = nmodules;
+            unsigned int now = millis();
+            for (unsigned int i = 0; i != n; ++i) {
+                ModuleSettings* s = &modules[i];
+                int count = oro_atomic_read( &s->suppressed );
+                if ( count == s->reported || now - s->reportedat < 1000 )
+                    continue;
+                char text[ModuleNameSize + 80];
+                snprintf( text, sizeof(text), "%d lines of module '%s' were suppressed by its rate limit.", count - s->reported, s->name );
+                s->reported = count;
+                s->reportedat = now;
+                std::string res = showTime() + " " + showLevel(Warning) + "[Logger] ";
+                if ( Warning <= outloglevel && mlogStdOut )
+                    output(res, text, Logger::nl);
+                if ( mlogFile )
+                    outputFile(res, Warning, text, Logger::nl);
+                written = true;
+            }
+            return written;
+        }
+
+        /**
+         * Returns true if a module has a rate limit.
+         */
+        bool limited() const {
+            unsigned int n = nmodules;
+            for (unsigned int i = 0; i != n; ++i)
+                if ( modules[i].rate )
+                    return true;
+            return false;
+        }
+
+        enum { MaxThreads = 16, LineSize = 4096, MinQueueSize = 16384 };
+
+        /**
+         * The header of a log line in a queue of asynchronous mode.
+         * The text of the line follows it.
+         */
+        struct Record {
+            TimeService::ticks stamp;
+            //! The length of the text, or Wrap if the queue continues at its start.
+            unsigned int length;
+            LogLevel level;
+            bool tostd, tofile;
+            char module[ModuleNameSize];
+        };
+
+        static const unsigned int Wrap = ~0u;
+
+        /**
+         * A stream buffer which formats into a fixed-size array, such
+         * that composing a line does not allocate. Text beyond
+         * LineSize - 1 characters is dropped.
+         */
+        struct LineBuffer : public std::streambuf {
+            char text[LineSize];
+            LineBuffer() { reset(); }
+            void reset() { setp( text, text + LineSize - 1 ); }
+            unsigned int size() const { return pptr() - pbase(); }
+        };
+
+        /**
+         * The log state of one thread in asynchronous mode: the line it
+         * composes, with its own log level and module, and a queue of
+         * its finished lines. Only the owner composes and adds lines, and
+         * only the drain thread removes them, so neither takes a lock.
+         */
+        struct ThreadLog {
+            ThreadLog(unsigned int bytes)
+                : owned(0), generation(0), line(&buffer), level(Info), scope(0),
+                  state(LineEmpty), queue(new char[bytes]), size(bytes), head(0), tail(0)
+            {
+                module[0] = 0;
+            }
+            ~ThreadLog() { delete[] queue; }
+            //! 1 while a thread owns this buffer.
+            volatile int owned;
+            //! The asynchronous mode the level and module below were taken in.
+            unsigned int generation;
+            LineBuffer buffer;
+            std::ostream line;
+            LogLevel level;
+            char module[ModuleNameSize];
+            ModuleSettings* scope;
+            //! The LineState of line.
+            int state;
+            char* queue;
+            //! The size of queue, a power of two.
+            unsigned int size;
+            //! The bytes ever added to and removed from queue.
+            volatile unsigned int head, tail;
+        };
+
+        /**
+         * Returns the buffer of the calling thread in asynchronous mode,
+         * which it claims on first use. Returns null in synchronous mode
+         * and when all buffers are taken. The thread then composes its
+         * lines under inpguard and queues them in the shared buffer.
+         */
+        ThreadLog* self() {
+#ifdef ORO_LOGGER_THREAD_BUFFERS
+            if ( !async )
+                return 0;
+            ThreadLog* t = (ThreadLog*) pthread_getspecific( threadkey );
+            bool claimed = false;
+            if ( t == 0 ) {
+                for (unsigned int i = 0; i != MaxThreads && t == 0; ++i)
+                    if ( threads[i]->owned == 0 && os::CAS( &threads[i]->owned, 0, 1 ) )
+                        t = threads[i];
+                if ( t == 0 )
+                    return 0;
+                pthread_setspecific( threadkey, t );
+                claimed = true;
+            }
+            if ( claimed || t->generation != generation ) {
+                // start from the global level and module, also if the
+                // buffer was left by an exited thread with its own level,
+                // module and half written line. A concurrent change of
+                // the module can at worst garble its name.
+                t->generation = generation;
+                t->level = inloglevel;
+                setModule( t, module );
+                t->state = LineEmpty;
+                t->buffer.reset();
+                t->line.clear();
+            }
+            return t;
+#else
+            return 0;
+#endif
+        }
+
+#ifdef ORO_LOGGER_THREAD_BUFFERS
+        /**
+         * Called when a thread with a buffer exits, such that another
+         * thread can take it. Its queued lines are still written out.
+         */
+        static void released(void* arg) {
+            ThreadLog* t = (ThreadLog*) arg;
+            os::CAS( &t->owned, 1, 0 );
+        }
+#endif
+
+        static unsigned int align(unsigned int n) {
+            return (n + 7) & ~7u;
+        }
+
+        /**
+         * Adds a line with header \a r to the queue of \a t. Does not
+         * lock or allocate. Only called by the thread which owns \a t,
+         * or with inpguard held for the shared buffer.
+         * @return false if the queue is full.
+         */
+        bool push(ThreadLog* t, const Record& r, const char* text) {
+            unsigned int need = sizeof(Record) + align(r.length);
+            unsigned int head = t->head;
+            unsigned int pos = head & (t->size - 1);
+            // a line does not wrap around, but continues at the start.
+            unsigned int skip = t->size - pos < need ? t->size - pos : 0;
+            if ( t->size - (head - t->tail) < skip + need )
+                return false;
+            if ( skip ) {
+                if ( skip >= sizeof(Record) )
+                    ((Record*) (t->queue + pos))->length = Wrap;
+                pos = 0;
+            }
+            memcpy( t->queue + pos, &r, sizeof(Record) );
+            memcpy( t->queue + pos + sizeof(Record), text, r.length );
+            // also a memory barrier: the line is complete before it is published.
+            os::CAS( &t->head, head, head + skip + need );
+            return true;
+        }
+
+        /**
+         * Returns the oldest line in the queue of \a t, or null if it
+         * is empty. Only called by the drain thread.
+         */
+        Record* front(ThreadLog* t) {
+            while ( t->tail != t->head ) {
+                unsigned int tail = t->tail;
+                unsigned int pos = tail & (t->size - 1);
+                Record* r = (Record*) (t->queue + pos);
+                if ( t->size - pos >= sizeof(Record) && r->length != Wrap )
+                    return r;
+                os::CAS( &t->tail, tail, tail + t->size - pos );
+            }
+            return 0;
+        }
+
+        /**
+         * Removes line \a r, as returned by front(), from the queue of \a t.
+         */
+        void pop(ThreadLog* t, Record* r) {
+            unsigned int tail = t->tail;
+            os::CAS( &t->tail, tail, tail + sizeof(Record) + align(r->length) );
+        }
+
+        /**
+         * Returns the oldest queued line of all threads and stores the
+         * buffer it is in in \a from. Returns null if nothing is queued.
+         */
+        Record* oldest(ThreadLog*& from) {
+            Record* r = 0;
+            for (unsigned int i = 0; i <= MaxThreads; ++i) {
+                ThreadLog* t = i == MaxThreads ? shared : threads[i];
+                Record* f = t ? front(t) : 0;
+                if ( f && ( r == 0 || f->stamp < r->stamp ) ) {
+                    r = f;
+                    from = t;
+                }
+            }
+            return r;
+        }
+
+        /**
+         * Queues the line composed in the buffer of \a t, if its level
+         * and module let it be logged. Does not lock or allocate.
+         */
+        void finish(ThreadLog* t) {
+            ModuleSettings* s = t->scope;
+            Record r;
+            r.tostd = maylogStdOut(t->level, s);
+            r.tofile = maylogFile(t->level, s);
+            if ( ( r.tostd || r.tofile ) && admit( t->state, s ) ) {
+                r.stamp = TimeService::Instance()->getTicks();
+                r.length = t->buffer.size();
+                r.level = t->level;
+                strcpy( r.module, t->module );
+                if ( !push( t, r, t->buffer.text ) )
+                    oro_atomic_inc(&overflows);
+            }
+            t->state = LineEmpty;
+            t->buffer.reset();
+            t->line.clear();
+        }
+
+        /**
+         * The low priority thread which does the I/O of the queued log
+         * lines in asynchronous mode, and reports lines suppressed by
+         * rate limits. It runs while the logger is asynchronous or a
+         * module is rate limited.
+         */
+        struct Drainer : public os::Thread
+        {
+            D* d;
+            Drainer(D* d_)
+                : os::Thread(ORO_SCHED_OTHER, os::LowestPriority, 0.05, 0, "Logger"), d(d_)
+            {}
+            void step() { d->drain(true); }
+            void finalize() { d->drain(true); }
+        };
+
         /**
          * This function is called when a new message is ready to be
          * written to screen, disk, or stream. 'logline' or 'remotestream'
          * contain a single log message. Time and location is prepended.
+         * In asynchronous mode, the message is queued instead.
          */
         void logit(std::ostream& (*pf)(std::ostream&))
         {
+            // in asynchronous mode, most threads have their own buffer.
+            ThreadLog* t = self();
+            if ( t ) {
+                finish(t);
+                return;
+            }
             // only on Logger::nl or Logger::endl, a time+log-line is written.
             os::MutexLock lock( inpguard );
+            bool admitted = admit( linestate, scope );
+            linestate = LineEmpty;
+            if ( !admitted ) {
+                // a suppressed line has no text, except from manipulators.
+                logline.str("");
+#if defined(OROSEM_FILE_LOGGING) || defined(OROSEM_REMOTE_LOGGING)
+                fileline.str("");
+#endif
+                return;
+            }
+            if ( async ) {
+                queue();
+                return;
+            }
             std:: string res = showTime() +" " + showLevel(inloglevel) + showModule() + " ";
 
+            os::MutexLock olock( outguard );
             // do not log if not wanted.
-            if ( maylogStdOut() ) {
+            if ( maylogStdOut(inloglevel, scope) ) {
+                output(res, logline.str(), pf);
+                logline.str("");   // clear stringstream.
+            }
+
+            if ( maylogFile(inloglevel, scope) ) {
+#if defined(OROSEM_FILE_LOGGING) || defined(OROSEM_REMOTE_LOGGING)
+                outputFile(res, inloglevel, fileline.str(), pf);
+                fileline.str("");
+#endif
+            }
+        }
+
+        /**
+         * Writes a log line to the standard output stream.
+         * outguard must be held.
+         */
+        void output(const std::string& prefix, const std::string& line, std::ostream& (*pf)(std::ostream&))
+        {
 #ifndef OROSEM_PRINTF_LOGGING
-                *stdoutput << res << logline.str() << pf;
+            *stdoutput << prefix << line << pf;
 #else
-                printf("%s%s\n", res.c_str(), logline.str().c_str() );
+            printf("%s%s\n", prefix.c_str(), line.c_str() );
 #endif
-                logline.str("");   // clear stringstream.
-            }
+        }
 
-            if ( maylogFile() ) {
+        /**
+         * Writes a log line to the log file and the remote log buffer.
+         * outguard must be held.
+         */
+        void outputFile(const std::string& prefix, LogLevel level, const std::string& line, std::ostream& (*pf)(std::ostream&))
+        {
 #ifdef OROSEM_FILE_LOGGING
 #if     defined(OROSEM_LOG4CPP_LOGGING)
-                category.log(level2Priority(inloglevel), fileline.str());
+            category.log(level2Priority(level), line);
 #elif   !defined(OROSEM_PRINTF_LOGGING)
-                logfile << res << fileline.str() << pf;
+            logfile << prefix << line << pf;
 #else
-                fprintf( logfile, "%s%s\n", res.c_str(), fileline.str().c_str() );
+            fprintf( logfile, "%s%s\n", prefix.c_str(), line.c_str() );
 #endif
 #ifdef OROSEM_REMOTE_LOGGING
-                remotestring.Push(res+fileline.str());  // TODO, handle failure.
+            remotestring.Push(prefix+line);  // TODO, handle failure.
+#endif
+#endif
+        }
+
+        /**
+         * Flushes the standard output and the log file.
+         * outguard must be held.
+         */
+        void flushOutput()
+        {
+#ifndef OROSEM_PRINTF_LOGGING
+            stdoutput->flush();
+#if defined(OROSEM_FILE_LOGGING)
+            logfile.flush();
+#endif
+#else
+            fflush(stdout);
+#if defined(OROSEM_FILE_LOGGING) && !defined(OROSEM_LOG4CPP_LOGGING)
+            fflush(logfile);
+#endif
 #endif
+        }
+
+        /**
+         * Copies the current message into the shared buffer, for a
+         * thread without a buffer of its own. This does not allocate and
+         * does not block on I/O. When the queue is full, the message is
+         * dropped and counted in overflows. inpguard must be held.
+         */
+        void queue()
+        {
+            Record r;
+            r.tostd = maylogStdOut(inloglevel, scope);
+            r.tofile = maylogFile(inloglevel, scope);
+            if ( !r.tostd && !r.tofile )
+                return;
+            r.stamp = TimeService::Instance()->getTicks();
+            r.level = inloglevel;
+            strcpy(r.module, module);
+            std::streamsize n = 0;
+            if ( r.tostd ) {
+                n = logline.rdbuf()->sgetn( sharedtext, LineSize - 1 );
+                logline.str("");
+            }
 #if defined(OROSEM_FILE_LOGGING) || defined(OROSEM_REMOTE_LOGGING)
+            if ( r.tofile ) {
+                if ( !r.tostd )
+                    n = fileline.rdbuf()->sgetn( sharedtext, LineSize - 1 );
                 fileline.str("");
+            }
 #endif
-#endif
+            r.length = n;
+            if ( !push( shared, r, sharedtext ) )
+                oro_atomic_inc(&overflows);
+        }
+
+        /**
+         * Writes out all queued log lines in one batch, in the order in
+         * which they were finished, and reports dropped lines. Called by
+         * the drain thread and when the asynchronous mode is left or the
+         * process crashes.
+         * @param wait If false, gives up when another thread is
+         * writing output.
+         */
+        void drain(bool wait)
+        {
+            if ( wait )
+                outguard.lock();
+            else if ( !outguard.trylock() )
+                return;
+            ThreadLog* t = 0;
+            Record* r;
+            bool written = false;
+            while ( (r = oldest(t)) ) {
+                std::string res = showTime(r->stamp) + " " + showLevel(r->level) + "[" + r->module + "] ";
+                std::string text( (const char*) (r + 1), r->length );
+                if ( r->tostd )
+                    output(res, text, Logger::nl);
+                if ( r->tofile )
+                    outputFile(res, r->level, text, Logger::nl);
+                pop(t, r);
+                written = true;
+            }
+            int lost = oro_atomic_read(&overflows);
+            if ( lost != reported ) {
+                std::stringstream msg;
+                msg << lost - reported << " log lines were dropped because the asynchronous log queue was full.";
+                std::string res = showTime(TimeService::Instance()->getTicks()) + " " + showLevel(Warning) + "[Logger] ";
+                if ( outloglevel >= Warning && mlogStdOut )
+                    output(res, msg.str(), Logger::nl);
+                if ( mlogFile )
+                    outputFile(res, Warning, msg.str(), Logger::nl);
+                reported = lost;
+                written = true;
+            }
+            if ( reportSuppressed() )
+                written = true;
+            if ( written )
+                flushOutput();
+            outguard.unlock();
+        }
+
+#ifdef ORO_LOGGER_CRASH_FLUSH
+        /**
+         * The D which is drained when the process crashes.
+         */
+        static D* crashlog;
+        struct sigaction crashactions[5];
+
+        static const int* crashSignals() {
+            static const int signals[5] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+            return signals;
+        }
+
+        /**
+         * Installs or removes the signal handlers which drain the
+         * queue when the process crashes.
+         */
+        void catchCrashes(bool on)
+        {
+            if ( on ) {
+                struct sigaction sa;
+                memset(&sa, 0, sizeof(sa));
+                sa.sa_handler = &D::crashed;
+                sigemptyset(&sa.sa_mask);
+                crashlog = this;
+                for (int i = 0; i != 5; ++i)
+                    sigaction( crashSignals()[i], &sa, &crashactions[i]);
+            } else {
+                for (int i = 0; i != 5; ++i)
+                    sigaction( crashSignals()[i], &crashactions[i], 0);
+                crashlog = 0;
             }
         }
 
+        /**
+         * Writes out what is still queued, restores the
+         * original handler and raises the signal again. This is a best
+         * effort: formatting the queued lines is not async-signal-safe.
+         */
+        static void crashed(int sig)
+        {
+            D* d = crashlog;
+            if ( d ) {
+                d->drain(false);
+                for (int i = 0; i != 5; ++i)
+                    if ( crashSignals()[i] == sig )
+                        sigaction( sig, &d->crashactions[i], 0);
+            } else
+                signal( sig, SIG_DFL );
+            raise(sig);
+        }
+#else
+        void catchCrashes(bool ) {}
+#endif
+
 #ifndef OROSEM_PRINTF_LOGGING
         std::ostream* stdoutput;
 #endif
@@ -267,6 +906,17 @@ namespace RTT
             return time.str();
         }
 
+        /**
+         * As showTime(), but for a message which was created at \a stamp.
+         */
+        std::string showTime(TimeService::ticks stamp) const
+        {
+            std::stringstream time;
+            if ( showtime )
+                time <<fixed<< showpoint << setprecision(3) << nsecs_to_Seconds( TimeService::ticks2nsecs(stamp - timestamp) );
+            return time.str();
+        }
+
         /**
          * Convert a loglevel to a string representation.
          */
@@ -305,8 +955,8 @@ namespace RTT
 
         std::string showModule() const
         {
-            // moduleptr is protected by lock in logIt()
-            return "["+moduleptr+"]";
+            // module is protected by lock in logIt()
+            return std::string("[") + module + "]";
         }
 
         bool started;
@@ -317,11 +967,95 @@ namespace RTT
 
         bool mlogStdOut, mlogFile;
 
-        std::string moduleptr;
+        /**
+         * The name of the current module. Stored in place, such
+         * that entering and leaving a module does not allocate.
+         */
+        char module[ModuleNameSize];
+
+        /**
+         * Sets the name of the current module. inpguard must be held.
+         */
+        void setModule(const char* modname)
+        {
+            strncpy(module, modname, ModuleNameSize - 1);
+            module[ModuleNameSize - 1] = 0;
+            scope = find(module);
+        }
+
+        /**
+         * Sets the module of thread buffer \a t. Only called by its owner.
+         */
+        void setModule(ThreadLog* t, const char* modname)
+        {
+            strncpy(t->module, modname, ModuleNameSize - 1);
+            t->module[ModuleNameSize - 1] = 0;
+            t->scope = find(t->module);
+        }
+
+        ModuleSettings modules[MaxModules];
+        volatile unsigned int nmodules;
+
+        /**
+         * The settings of the current module, or null if it has none.
+         */
+        ModuleSettings* volatile scope;
 
         os::Mutex inpguard;
+
+        /**
+         * Serializes the writes to the output streams, such that
+         * the drain thread does not need inpguard.
+         */
+        os::Mutex outguard;
+
+        bool async;
+        //! Incremented each time the asynchronous mode is entered.
+        unsigned int generation;
+        /**
+         * The buffers of the threads, and the one which threads without
+         * a buffer share. Created when the asynchronous mode is entered
+         * the first time and kept until the logger is destroyed.
+         */
+        ThreadLog* threads[MaxThreads];
+        ThreadLog* shared;
+        //! The text of a line queued in the shared buffer. inpguard must be held.
+        char sharedtext[LineSize];
+#ifdef ORO_LOGGER_THREAD_BUFFERS
+        pthread_key_t threadkey;
+#endif
+        oro_atomic_t overflows;
+        int reported;
+        Drainer* drainer;
+        //! Serializes starting and stopping the drain thread.
+        os::Mutex drainguard;
+        //! The LineState of the shared line. inpguard must be held.
+        int linestate;
+
+        void startDrainer()
+        {
+            os::MutexLock lock( drainguard );
+            if ( drainer )
+                return;
+            drainer = new Drainer(this);
+            drainer->start();
+        }
+
+        void stopDrainer()
+        {
+            os::MutexLock lock( drainguard );
+            if ( !drainer )
+                return;
+            drainer->stop();
+            delete drainer;
+            drainer = 0;
+        }
     };
 
+#ifdef ORO_LOGGER_CRASH_FLUSH
+    Logger::D* Logger::D::crashlog = 0;
+#endif
+
     Logger::Logger(std::ostream& str)
         :d ( new Logger::D(str, getenv("ORO_LOGFILE")) ),
          inpguard(d->inpguard), logline(d->logline), fileline(d->fileline)
@@ -331,6 +1065,8 @@ namespace RTT
 
     Logger::~Logger()
     {
+        this->setAsynchronous(false);
+        d->stopDrainer();
         delete d;
     }
 
@@ -338,6 +1074,48 @@ namespace RTT
         return d->maylog();
     }
 
+    bool Logger::mayLog(LogLevel ll) const {
+        if ( !d->maylog() )
+            return false;
+        D::ThreadLog* t = d->self();
+        D::ModuleSettings* s = t ? t->scope : d->scope;
+        if ( !( d->maylogStdOut(ll, s) || d->maylogFile(ll, s) ) )
+            return false;
+        return s == 0 || s->rate == 0 || d->available(s);
+    }
+
+    bool Logger::setLogLevel( const std::string& module, LogLevel ll ) {
+        os::MutexLock lock( d->inpguard );
+        D::ModuleSettings* s = d->settings( module.c_str() );
+        if ( s == 0 )
+            return false;
+        s->level = ll;
+        return true;
+    }
+
+    bool Logger::setRateLimit( const std::string& module, unsigned int rate, unsigned int burst ) {
+        {
+            os::MutexLock lock( d->inpguard );
+            D::ModuleSettings* s = d->settings( module.c_str() );
+            if ( s == 0 )
+                return false;
+            s->rate = 0; // disables the limit while it is changed.
+            s->burst = burst ? burst : 1;
+            s->tokens = s->burst;
+            s->refilled = d->millis();
+            s->rate = rate;
+        }
+        // the drain thread reports the suppressed lines.
+        if ( rate )
+            d->startDrainer();
+        return true;
+    }
+
+    unsigned int Logger::getSuppressedCount( const std::string& module ) const {
+        D::ModuleSettings* s = d->find( module.c_str() );
+        return s ? oro_atomic_read( &s->suppressed ) : 0;
+    }
+
     bool Logger::mayLogFile() const {
         return d->maylogFile();
     }
@@ -401,9 +1179,13 @@ namespace RTT
 
 
     Logger::In::In(const std::string& modname)
-        : oldmod( Logger::log().getLogModule() )
     {
-        Logger::log().in(modname);
+        Logger::log().enter(modname.c_str(), oldmod);
+    }
+
+    Logger::In::In(const char* modname)
+    {
+        Logger::log().enter(modname, oldmod);
     }
 
     Logger::In::~In()
@@ -411,29 +1193,68 @@ namespace RTT
         Logger::log().out(oldmod);
     }
 
+    void Logger::enter(const char* modname, char* oldmod)
+    {
+        oldmod[0] = 0;
+        if ( !d->maylog() )
+            return;
+        D::ThreadLog* t = d->self();
+        if ( t ) {
+            strcpy(oldmod, t->module);
+            d->setModule(t, modname);
+            return;
+        }
+        os::MutexLock lock( d->inpguard );
+        strcpy(oldmod, d->module);
+        d->setModule(modname);
+    }
+
     Logger& Logger::in(const std::string& modname)
+    {
+        return this->in( modname.c_str() );
+    }
+
+    Logger& Logger::in(const char* modname)
     {
         if ( !d->maylog() )
             return *this;
+        D::ThreadLog* t = d->self();
+        if ( t ) {
+            d->setModule(t, modname);
+            return *this;
+        }
         os::MutexLock lock( d->inpguard );
-        d->moduleptr = modname.c_str();
+        d->setModule(modname);
         return *this;
     }
 
     Logger& Logger::out(const std::string& oldmod)
+    {
+        return this->out( oldmod.c_str() );
+    }
+
+    Logger& Logger::out(const char* oldmod)
     {
         if ( !d->maylog() )
             return *this;
+        D::ThreadLog* t = d->self();
+        if ( t ) {
+            d->setModule(t, oldmod);
+            return *this;
+        }
         os::MutexLock lock( d->inpguard );
-        d->moduleptr = oldmod.c_str();
+        d->setModule(oldmod);
         return *this;
     }
 
     std::string Logger::getLogModule() const {
         if ( !d->maylog() )
             return "";
+        D::ThreadLog* t = d->self();
+        if ( t )
+            return t->module;
         os::MutexLock lock( d->inpguard );
-        std::string ret = d->moduleptr.c_str();
+        std::string ret = d->module;
         return ret;
     }
 
@@ -495,6 +1316,7 @@ namespace RTT
         if (!d->started)
             return;
         *this<<Logger::Info<<"Orocos Logging Deactivated." << Logger::endl;
+        this->setAsynchronous(false);
         this->logflush();
         d->started = false;
     }
@@ -521,17 +1343,94 @@ namespace RTT
 #endif
     }
 
-    Logger& Logger::operator<<( const char* t ) {
+    void Logger::setAsynchronous(bool async, unsigned int size) {
+        if ( async == d->async )
+            return;
+        if ( async ) {
+            if ( d->shared == 0 ) {
+                unsigned int bytes = D::MinQueueSize;
+                while ( bytes < size )
+                    bytes *= 2;
+                for (unsigned int i = 0; i != D::MaxThreads; ++i)
+                    d->threads[i] = new D::ThreadLog( bytes );
+                d->shared = new D::ThreadLog( bytes );
+            }
+            {
+                os::MutexLock lock( d->inpguard );
+                ++d->generation;
+                d->async = true;
+            }
+            d->catchCrashes(true);
+            d->startDrainer();
+        } else {
+            // the thread logs while stopping, so it must be drained
+            // after it stopped. It keeps running for rate limits.
+            if ( !d->limited() )
+                d->stopDrainer();
+            {
+                os::MutexLock lock( d->inpguard );
+                d->async = false;
+            }
+            d->drain(true);
+            d->catchCrashes(false);
+        }
+    }
+
+    bool Logger::isAsynchronous() const {
+        return d->async;
+    }
+
+    unsigned int Logger::getOverflowCount() const {
+        return oro_atomic_read(&d->overflows);
+    }
+
+    bool Logger::threadLine( std::ostream*& line ) {
+        D::ThreadLog* t = d->self();
+        if ( t == 0 )
+            return false;
+        // a suppressed line is not formatted.
+        line = d->admit( t->state, t->scope ) ? &t->line : 0;
+        return true;
+    }
+
+    bool Logger::admitLine() {
+        return d->admit( d->linestate, d->scope );
+    }
+
+    bool Logger::admit(LogLevel ll) {
         if ( !d->maylog() )
+            return false;
+        D::ThreadLog* t = d->self();
+        D::ModuleSettings* s = t ? t->scope : d->scope;
+        // a line of a disabled level is dropped without locking.
+        if ( !( d->maylogStdOut(ll, s) || d->maylogFile(ll, s) ) )
+            return false;
+        if ( t )
+            return d->admit( t->state, t->scope );
+        // the module may have changed meanwhile.
+        os::MutexLock lock( d->inpguard );
+        return ( d->maylogStdOut(ll, d->scope) || d->maylogFile(ll, d->scope) ) && d->admit( d->linestate, d->scope );
+    }
+
+    Logger& Logger::operator<<( const char* t ) {
+        if ( !d->maylog() || !( d->maylogStdOut() || d->maylogFile() ) )
             return *this;
 
+        std::ostream* line = 0;
+        if ( this->threadLine(line) ) {
+            if ( line )
+                *line << t;
+            return *this;
+        }
         os::MutexLock lock( d->inpguard );
-        if ( d->maylogStdOut() )
+        if ( !this->admitLine() )
+            return *this;
+        if ( d->maylogStdOut(d->inloglevel, d->scope) )
             d->logline << t;
 
 #if defined(OROSEM_FILE_LOGGING) || defined(OROSEM_REMOTE_LOGGING)
         // log Info or better to log file, even if not started.
-        if ( d->maylogFile() )
+        if ( d->maylogFile(d->inloglevel, d->scope) )
             d->fileline << t;
 #endif
         return *this;
@@ -544,7 +1443,11 @@ namespace RTT
     Logger& Logger::operator<<(LogLevel ll) {
         if ( !d->maylog() )
             return *this;
-        d->inloglevel = ll;
+        D::ThreadLog* t = d->self();
+        if ( t )
+            t->level = ll;
+        else
+            d->inloglevel = ll;
         return *this;
     }
 
@@ -559,11 +1462,19 @@ namespace RTT
         else if ( pf == Logger::flush )
             this->logflush();
         else {
+            std::ostream* line = 0;
+            if ( this->threadLine(line) ) {
+                if ( line )
+                    *line << pf;
+                return *this;
+            }
             os::MutexLock lock( d->inpguard );
-            if ( d->maylogStdOut() )
+            if ( !this->admitLine() )
+                return *this;
+            if ( d->maylogStdOut(d->inloglevel, d->scope) )
                 d->logline << pf; // normal std operator in stream.
 #if defined(OROSEM_FILE_LOGGING) || defined(OROSEM_REMOTE_LOGGING)
-            if ( d->maylogFile() )
+            if ( d->maylogFile(d->inloglevel, d->scope) )
                 d->fileline << pf;
 #endif
         }
@@ -571,18 +1482,20 @@ namespace RTT
     }
 
     void Logger::logflush() {
-        if (!d->maylog())
+        // in asynchronous mode, the drain thread flushes after each batch.
+        if (!d->maylog() || d->async)
             return;
         {
             // just flush all buffers, do not produce a new logline
             os::MutexLock lock( d->inpguard );
-            if ( d->maylogStdOut() ) {
+            os::MutexLock olock( d->outguard );
+            if ( d->maylogStdOut(d->inloglevel, d->scope) ) {
 #ifndef OROSEM_PRINTF_LOGGING
                 d->stdoutput->flush();
 #endif
             }
 #if defined(OROSEM_FILE_LOGGING)
-            if ( d->maylogFile() ) {
+            if ( d->maylogFile(d->inloglevel, d->scope) ) {
 #ifndef OROSEM_PRINTF_LOGGING
                 d->logfile.flush();
 #endif
@@ -592,13 +1505,13 @@ namespace RTT
      }
 
     void Logger::lognl() {
-        if (!d->maylog())
+        if ( !d->maylog() || !( d->maylogStdOut() || d->maylogFile() ) )
             return;
         d->logit( Logger::nl );
      }
 
     void Logger::logendl() {
-        if (!d->maylog())
+        if ( !d->maylog() || !( d->maylogStdOut() || d->maylogFile() ) )
             return;
         d->logit( Logger::endl );
      }
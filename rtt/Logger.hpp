@@ -142,6 +142,53 @@ namespace RTT
          */
         void mayLogFile(bool tf);
 
+        /**
+         * Switch the logger to or from asynchronous mode. In asynchronous
+         * mode, each thread formats its lines into a fixed-size buffer of
+         * its own and copies finished lines into its own preallocated
+         * queue, without taking a lock or allocating memory. A low
+         * priority thread writes the queued lines of all threads, in
+         * the order they were finished, to the standard output and the
+         * log file in batches. The level of the next message and the
+         * module entered with Logger::In are also kept per thread.
+         *
+         * On POSIX targets, up to 16 threads get a buffer. Other threads,
+         * and all threads on other targets, compose their lines under the
+         * logger's lock and share one more queue. Lines longer than 4095
+         * characters are truncated and lines which do not fit in their
+         * queue are dropped and counted. On POSIX targets, the queues are
+         * also written out when the process receives a crash signal
+         * (SIGSEGV, SIGBUS, SIGFPE, SIGILL or SIGABRT).
+         *
+         * @param async true to enable asynchronous mode, false to write
+         * out what is queued and return to synchronous logging.
+         * @param size The size in bytes of each queue, at least 16 KiB.
+         * Only used the first time asynchronous mode is entered, since
+         * the queues are kept until the logger is destroyed.
+         * @warning Do not call this method concurrently with itself or
+         * with shutdown().
+         */
+        void setAsynchronous(bool async, unsigned int size = 65536);
+
+        /**
+         * Returns true if the logger is in asynchronous mode.
+         * @see setAsynchronous()
+         */
+        bool isAsynchronous() const;
+
+        /**
+         * Returns the number of log lines which were dropped because
+         * the asynchronous queue was full. The drain thread also logs
+         * a warning each time lines were dropped.
+         */
+        unsigned int getOverflowCount() const;
+
+        /**
+         * The maximum length of a module name, including the terminating
+         * null character. Longer module names are truncated.
+         */
+        static const unsigned int ModuleNameSize = 64;
+
         /**
          * Notify the Logger in which 'module' the message occured. This returns an object
          * whose scope (i.e. {...} ) is indicative for the boundaries of the module.
@@ -155,11 +202,14 @@ namespace RTT
          }
          Logger::log() << Logger::Info << "A message in module 'Logger'..."<<Logger::endl;
          @endverbatim
+         * Entering and leaving a module does not allocate memory. Prefer
+         * passing a string literal, which avoids constructing a std::string.
         */
         struct RTT_API In {
             In(const std::string& module);
+            In(const char* module);
             ~In();
-			std::string oldmod;
+            char oldmod[ModuleNameSize];
         };
 
         /**
@@ -167,12 +217,14 @@ namespace RTT
          * @see In. Use Logger::In(\a modname) for management.
          */
         Logger& in(const std::string& modname);
+        Logger& in(const char* modname);
 
         /**
          * The counterpart of in().
          * @see In. Use Logger::In(\a modname) for management.
          */
         Logger& out(const std::string& modname);
+        Logger& out(const char* modname);
 
         /**
          * Get the name of the current Log generating Module.
@@ -293,6 +345,51 @@ namespace RTT
          */
         LogLevel getLogLevel() const;
 
+        /**
+         * Set the loglevel of the outgoing messages of one module, as
+         * entered with Logger::In. This level replaces the global level
+         * of setLogLevel() for both the standard output and the log file,
+         * so a module can be made more or less verbose than the others.
+         * @return false if too many modules (32) have their own settings.
+         */
+        bool setLogLevel( const std::string& module, LogLevel ll );
+
+        /**
+         * Limit the number of lines module \a module may log with a token
+         * bucket: the module may log \a burst lines at once, and earns
+         * \a rate lines per second. The limit is applied when a line
+         * starts, so the text of an excess line is not formatted. ORO_LOG
+         * messages are dropped before their arguments are evaluated.
+         * A low priority thread of the logger reports, at most once per
+         * second per module, how many lines were dropped.
+         * @param rate The number of lines per second. Zero disables the limit.
+         * @param burst The maximum number of lines logged in one burst.
+         * @return false if too many modules (32) have their own settings.
+         */
+        bool setRateLimit( const std::string& module, unsigned int rate, unsigned int burst = 10 );
+
+        /**
+         * Returns the total number of lines of \a module which were
+         * dropped by its rate limit.
+         */
+        unsigned int getSuppressedCount( const std::string& module ) const;
+
+        /**
+         * Returns true if a message of LogLevel \a ll would appear on the
+         * standard output or in the log file. Use this to avoid composing
+         * a message which will be dropped anyway. This only queries: it
+         * does not take a token of a rate limited module.
+         * @see admit()
+         */
+        bool mayLog(LogLevel ll) const;
+        /**
+         * As mayLog(\a ll), but also starts the message: if the current
+         * module is rate limited, the message takes a token, or is
+         * counted as suppressed. A message of a disabled level is
+         * rejected without taking a lock. Used by ORO_LOG.
+         */
+        bool admit(LogLevel ll);
+
         /**
          * Flush log buffers. May log nothing if empty.
          */
@@ -329,6 +426,24 @@ namespace RTT
         bool mayLogStdOut() const;
         bool mayLogFile() const;
 
+        /**
+         * Enters module \a modname and stores the name of the module
+         * that was left in \a oldmod, which holds ModuleNameSize characters.
+         */
+        void enter(const char* modname, char* oldmod);
+        /**
+         * Returns true if the calling thread composes its lines in a
+         * buffer of its own. \a line is then set to that buffer, or to
+         * null if the line is suppressed by a rate limit.
+         */
+        bool threadLine(std::ostream*& line);
+        /**
+         * Applies the rate limit to the line composed under inpguard,
+         * which must be held.
+         * @return false if the line is suppressed.
+         */
+        bool admitLine();
+
         Logger(std::ostream& str=std::cerr);
         ~Logger();
 
@@ -381,6 +496,27 @@ namespace RTT
     static inline Logger::LogFunction flushlog() {return Logger::flush; }
 }
 
+/**
+ * The least important LoggerLevel which ORO_LOG compiles in, as a
+ * number (0..7). ORO_LOG messages with a less important level are removed
+ * at compile time. Define it before including this header, for example
+ * with -DORO_LOG_MIN_LEVEL=4 to keep only warnings and more important
+ * messages. The default keeps all levels.
+ */
+#ifndef ORO_LOG_MIN_LEVEL
+#define ORO_LOG_MIN_LEVEL 7
+#endif
+
+/**
+ * Starts a log message of LoggerLevel \a level. Unlike log(level), the
+ * rest of the statement, including the arguments of operator<<, is only
+ * evaluated if the message will actually be logged.
+ * Usage: ORO_LOG(Debug) << "Result: " << expensive() << endlog();
+ */
+#define ORO_LOG(level) \
+    if ( int(RTT::Logger::level) > ORO_LOG_MIN_LEVEL || !RTT::Logger::log().admit(RTT::Logger::level) ) {} \
+    else RTT::Logger::log(RTT::Logger::level)
+
 #include "Logger.inl"
 
 #endif
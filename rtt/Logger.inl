@@ -14,10 +14,18 @@ namespace RTT
     template< class T>
     Logger& Logger::operator<<( const T &t ) {
 #ifndef OROBLD_DISABLE_LOGGING
-        if ( !mayLog() )
+        if ( !mayLog() || !( this->mayLogStdOut() || this->mayLogFile() ) )
             return *this;
 
+        std::ostream* line = 0;
+        if ( this->threadLine(line) ) {
+            if ( line )
+                *line << t;
+            return *this;
+        }
         os::MutexLock lock( inpguard );
+        if ( !this->admitLine() )
+            return *this;
         if ( this->mayLogStdOut() )
             logline << t;
 
@@ -51,6 +59,17 @@ namespace RTT
     inline void Logger::mayLogFile(bool ) {
     }
 
+    inline void Logger::setAsynchronous(bool, unsigned int) {
+    }
+
+    inline bool Logger::isAsynchronous() const {
+        return false;
+    }
+
+    inline unsigned int Logger::getOverflowCount() const {
+        return 0;
+    }
+
     inline void Logger::allowRealTime() {
     }
 
@@ -80,6 +99,10 @@ namespace RTT
     {
     }
 
+    inline Logger::In::In(const char*)
+    {
+    }
+
     inline Logger::In::~In()
     {
     }
@@ -89,11 +112,21 @@ namespace RTT
         return *this;
     }
 
+    inline Logger& Logger::in(const char*)
+    {
+        return *this;
+    }
+
     inline Logger& Logger::out(const std::string&)
     {
         return *this;
     }
 
+    inline Logger& Logger::out(const char*)
+    {
+        return *this;
+    }
+
     inline std::string Logger::getLogModule() const {
         return "";
     }
@@ -136,6 +169,26 @@ namespace RTT
     inline void Logger::setLogLevel( LogLevel ) {
     }
 
+    inline bool Logger::mayLog(LogLevel) const {
+        return false;
+    }
+
+    inline bool Logger::admit(LogLevel) {
+        return false;
+    }
+
+    inline bool Logger::setLogLevel( const std::string&, LogLevel ) {
+        return false;
+    }
+
+    inline bool Logger::setRateLimit( const std::string&, unsigned int, unsigned int ) {
+        return false;
+    }
+
+    inline unsigned int Logger::getSuppressedCount( const std::string& ) const {
+        return 0;
+    }
+
     inline Logger::LogLevel Logger::getLogLevel() const {
         return Never;
     }
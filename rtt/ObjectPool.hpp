@@ -0,0 +1,272 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef ORO_OBJECT_POOL_HPP
+#define ORO_OBJECT_POOL_HPP
+
+#include "internal/TsPool.hpp"
+#include "os/oro_arch.h"
+#include "os/CAS.hpp"
+#include "os/Mutex.hpp"
+#include "os/MutexLock.hpp"
+
+namespace RTT
+{
+    /**
+     * A thread-safe pool of preallocated objects of type \a T.
+     *
+     * Components use an ObjectPool to recycle large objects, like images
+     * or laser scans, in real-time code without allocating memory. All
+     * objects are created up-front as copies of a sample object. allocate()
+     * hands out an object wrapped in a Handle, and the object returns to
+     * the pool when the last Handle to it is destroyed or reset. Objects
+     * are recycled as-is: they keep the contents and the capacity they had
+     * when they were returned.
+     *
+     * allocate() and releasing a Handle are lock-free and may be called
+     * concurrently from any number of threads. The pool only grows by an
+     * explicit reserve(), or by allocate() if a growth increment was set
+     * with setGrowth(). Growing allocates memory and is thus not real-time;
+     * only set a growth increment if allocate() is never called from a
+     * real-time thread, or if the pool is sized such that it does not
+     * run empty.
+     *
+     * All Handles must have been released before the pool is destroyed.
+     *
+     * @param T The type of the objects in this pool. It must be default
+     * constructible and copyable.
+     * @ingroup CoreLibBuffers
+     */
+    template<typename T>
+    class ObjectPool
+    {
+        /**
+         * The object must be the first member, see internal::TsPool.
+         */
+        struct Slot
+        {
+            T value;
+            oro_atomic_t refs;
+            internal::TsPool<Slot>* owner;
+
+            Slot(const T& sample = T()) : value(sample), owner(0) {
+                ORO_ATOMIC_SETUP(&refs, 0);
+            }
+            Slot(const Slot& orig) : value(orig.value), owner(0) {
+                ORO_ATOMIC_SETUP(&refs, 0);
+            }
+            ~Slot() {
+                ORO_ATOMIC_CLEANUP(&refs);
+            }
+            Slot& operator=(const Slot& orig) {
+                value = orig.value;
+                return *this;
+            }
+        };
+
+        /**
+         * A TsPool can hold at most this number of elements.
+         */
+        static const unsigned int MaxSegmentSize = 65534;
+        /**
+         * The pool can be grown at most this number of times.
+         */
+        static const unsigned int MaxSegments = 32;
+
+        internal::TsPool<Slot>* msegments[MaxSegments];
+        volatile unsigned int mcount;
+        unsigned int mcapacity;
+        unsigned int mgrowth;
+        T msample;
+        os::Mutex mlock;
+
+        ObjectPool(const ObjectPool&);
+        ObjectPool& operator=(const ObjectPool&);
+    public:
+        typedef T value_t;
+
+        /**
+         * Gives access to an object of an ObjectPool. Copies of a
+         * Handle refer to the same object, which returns to its pool
+         * when the last Handle referring to it is destroyed or reset.
+         * A Handle can be copied and released in real-time. It is not
+         * safe to access the same Handle instance from multiple threads.
+         */
+        class Handle
+        {
+            friend class ObjectPool<T>;
+            Slot* mslot;
+
+            explicit Handle(Slot* s) : mslot(s) {}
+        public:
+            /**
+             * Creates a Handle which does not refer to any object.
+             */
+            Handle() : mslot(0) {}
+
+            Handle(const Handle& orig) : mslot(orig.mslot) {
+                if (mslot)
+                    oro_atomic_inc(&mslot->refs);
+            }
+
+            ~Handle() {
+                reset();
+            }
+
+            Handle& operator=(const Handle& orig) {
+                if (orig.mslot)
+                    oro_atomic_inc(&orig.mslot->refs);
+                reset();
+                mslot = orig.mslot;
+                return *this;
+            }
+
+            /**
+             * Stops referring to the object, and returns it to its
+             * pool if this was the last Handle referring to it.
+             */
+            void reset() {
+                if (mslot && oro_atomic_dec_and_test(&mslot->refs))
+                    mslot->owner->deallocate(mslot);
+                mslot = 0;
+            }
+
+            /**
+             * Returns true if this Handle refers to an object.
+             */
+            bool valid() const { return mslot != 0; }
+
+            /**
+             * Returns the object or null if this Handle is not valid.
+             */
+            T* get() const { return mslot ? &mslot->value : 0; }
+
+            T& operator*() const { return mslot->value; }
+
+            T* operator->() const { return &mslot->value; }
+        };
+
+        /**
+         * Creates a pool of \a size copies of \a sample.
+         * @param size The number of objects to allocate up-front.
+         * @param sample The object each object of this pool is copied from.
+         * @param growth The number of objects allocate() adds when the
+         * pool is empty. Zero means that allocate() never grows the pool.
+         */
+        ObjectPool(unsigned int size, const T& sample = T(), unsigned int growth = 0)
+            : mcount(0), mcapacity(0), mgrowth(growth), msample(sample)
+        {
+            reserve(size);
+        }
+
+        /**
+         * Destroys all objects. All Handles must have been released.
+         */
+        ~ObjectPool() {
+            for (unsigned int i = 0; i != mcount; ++i)
+                delete msegments[i];
+        }
+
+        /**
+         * Returns an unused object of this pool.
+         * This function is lock-free, unless the pool must grow.
+         * @return A Handle to the object, which is not valid if the pool
+         * is empty and could not grow.
+         */
+        Handle allocate() {
+            unsigned int count = mcount;
+            for (unsigned int i = 0; i != count; ++i) {
+                Slot* s = msegments[i]->allocate();
+                if (s) {
+                    s->owner = msegments[i];
+                    oro_atomic_set(&s->refs, 1);
+                    return Handle(s);
+                }
+            }
+            if ( mgrowth != 0 && reserve(mgrowth) )
+                return allocate();
+            return Handle();
+        }
+
+        /**
+         * Adds \a additional objects to this pool. This function
+         * allocates memory and is not real-time.
+         * @return false if the pool can not grow anymore.
+         */
+        bool reserve(unsigned int additional) {
+            os::MutexLock lock(mlock);
+            while ( additional != 0 ) {
+                if ( mcount == MaxSegments )
+                    return false;
+                unsigned int size = additional < MaxSegmentSize ? additional : MaxSegmentSize;
+                msegments[mcount] = new internal::TsPool<Slot>( size, Slot(msample) );
+                mcapacity += size;
+                additional -= size;
+                // publish the new segment after it was filled in.
+                unsigned int count = mcount;
+                os::CAS(&mcount, count, count + 1);
+            }
+            return true;
+        }
+
+        /**
+         * Sets the number of objects allocate() adds when the pool is
+         * empty. Zero, the default, means that allocate() never grows
+         * the pool.
+         */
+        void setGrowth(unsigned int growth) {
+            mgrowth = growth;
+        }
+
+        unsigned int getGrowth() const {
+            return mgrowth;
+        }
+
+        /**
+         * Returns the total number of objects of this pool.
+         */
+        unsigned int capacity() const {
+            return mcapacity;
+        }
+
+        /**
+         * Returns the number of objects that can be allocated without
+         * growing the pool. This function is not thread-safe and may
+         * not be used while objects are allocated or released.
+         */
+        unsigned int size() const {
+            unsigned int ret = 0;
+            for (unsigned int i = 0; i != mcount; ++i)
+                ret += msegments[i]->size();
+            return ret;
+        }
+    };
+}
+
+#endif
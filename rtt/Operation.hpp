@@ -136,6 +136,21 @@ namespace RTT
          */
         Operation<Signature>& arg(const std::string& name, const std::string& description) { marg(name, description); return *this; }
 
+        /**
+         * Set the message lane in which this operation is queued when it
+         * is sent to an OwnThread owner. Use HighPriority for operations
+         * which may not be delayed by a flood of other messages, such as
+         * an emergency stop.
+         * @param prio The priority class of this operation.
+         * @return A reference to this object.
+         */
+        Operation<Signature>& priority(MessagePriority prio) {
+            mpriority = prio;
+            if (impl)
+                impl->setPriority(prio);
+            return *this;
+        }
+
         /**
          * Indicate that this operation calls a given function.
          * This will replace any previously registered function present in this operation.
@@ -148,6 +163,7 @@ namespace RTT
             // creates a Local OperationCaller
             ExecutionEngine* null_caller = 0;
             impl = boost::make_shared<internal::LocalOperationCaller<Signature> >(func, ownerEngine ? ownerEngine : this->mowner, null_caller, et);
+            impl->setPriority(mpriority);
 #ifdef ORO_SIGNALLING_OPERATIONS
             if (signal)
                 impl->setSignal(signal);
@@ -169,6 +185,7 @@ namespace RTT
             // creates a Local OperationCaller or sets function
             ExecutionEngine* null_caller = 0;
             impl = boost::make_shared<internal::LocalOperationCaller<Signature> >(func, o, ownerEngine ? ownerEngine : this->mowner, null_caller, et);
+            impl->setPriority(mpriority);
 #ifdef ORO_SIGNALLING_OPERATIONS
             if (signal)
                 impl->setSignal(signal);
@@ -370,6 +370,17 @@ namespace RTT
                 this->impl->setCaller(caller);
         }
 
+        /**
+         * Overrides the message lane in which this caller's sends are
+         * queued in the receiving ExecutionEngine. By default, the
+         * priority set on the Operation is used.
+         * @param prio The priority class to use for calls done through this object.
+         */
+        void setPriority(MessagePriority prio) {
+            if (this->impl)
+                this->impl->setPriority(prio);
+        }
+
         void disconnect()
         {
             this->impl.reset();
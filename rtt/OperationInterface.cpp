@@ -55,8 +55,14 @@ boost::shared_ptr<base::DisposableInterface> OperationInterfacePart::getLocalOpe
     return boost::shared_ptr<base::DisposableInterface>();
 }
 
+OperationInterface::OperationInterface()
+    : mrevision(0)
+{
+}
+
 void OperationInterface::clear()
 {
+    mrevision.inc();
     for (map_t::iterator i = data.begin(); i != data.end(); ++i)
         delete i->second;
     data.clear();
@@ -173,6 +179,7 @@ void OperationInterface::add(const std::string& name, OperationInterfacePart* pa
     if (i != data.end())
         delete i->second;
     data[name] = part;
+    mrevision.inc();
 }
 
 void OperationInterface::remove(const std::string& name)
@@ -182,6 +189,7 @@ void OperationInterface::remove(const std::string& name)
     {
         delete i->second;
         data.erase(i);
+        mrevision.inc();
     }
 }
 
@@ -195,3 +203,7 @@ OperationInterfacePart* OperationInterface::getPart(const std::string& name)
     return 0;
 }
 
+unsigned int OperationInterface::getRevision() const
+{
+    return mrevision.read();
+}
@@ -49,6 +49,7 @@
 #include "ArgumentDescription.hpp"
 #include "FactoryExceptions.hpp"
 #include "OperationInterfacePart.hpp"
+#include "os/Atomic.hpp"
 
 
 namespace RTT
@@ -64,7 +65,14 @@ namespace RTT
     protected:
         typedef std::map<std::string, OperationInterfacePart*> map_t;
         map_t data;
+        /**
+         * Read by other threads, such as those of a CORBA servant,
+         * while the owner adds and removes operations.
+         */
+        os::AtomicInt mrevision;
     public:
+        OperationInterface();
+
         /**
          * The arguments for an operation.
          */
@@ -254,6 +262,13 @@ namespace RTT
          * @return
          */
         OperationInterfacePart* getPart(const std::string& name);
+
+        /**
+         * Returns a number which changes each time an operation is
+         * added, replaced or removed. A part returned by getPart() may
+         * be deleted as soon as the revision changes.
+         */
+        unsigned int getRevision() const;
     };
 }
 
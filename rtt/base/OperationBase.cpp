@@ -52,7 +52,7 @@ namespace RTT
     {
 
         OperationBase::OperationBase(const std::string& name)
-        :mname(name),mowner(0)
+        :mname(name),mowner(0),mpriority(NormalPriority)
         {
             descriptions.push_back("(not documented)");
         }
@@ -45,6 +45,7 @@
 #include <string>
 #include <vector>
 #include "DisposableInterface.hpp"
+#include "../MessagePriority.hpp"
 
 namespace RTT
 {
@@ -70,6 +71,7 @@ namespace RTT
             std::string mname;
             std::vector<std::string> descriptions;
             ExecutionEngine* mowner;
+            MessagePriority mpriority;
             RTT_API void mdoc(const std::string& description);
             RTT_API void marg(const std::string& name, const std::string& description);
             virtual void ownerUpdated() = 0;
@@ -122,6 +124,14 @@ namespace RTT
             ExecutionEngine* getOwner() const {
                 return mowner;
             }
+
+            /**
+             * Returns the message lane in which this operation is
+             * queued when it is sent to its owner.
+             */
+            MessagePriority getPriority() const {
+                return mpriority;
+            }
         };
     }
 }
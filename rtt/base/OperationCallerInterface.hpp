@@ -66,6 +66,15 @@ namespace RTT
 
             ExecutionThread getThread() const { return met; }
 
+            /**
+             * Sets the message lane used when this operation is sent
+             * to its owner's ExecutionEngine.
+             * @param prio The priority class of the messages sent by this object.
+             */
+            void setPriority(MessagePriority prio) { mpriority = prio; }
+
+            MessagePriority getPriority() const { return mpriority; }
+
             /**
              * Executed when the operation execution resulted in a
              * C++ exception. Must report the error to the ExecutionEngine
@@ -84,6 +93,7 @@ namespace RTT
             ExecutionEngine* myengine;
             ExecutionEngine* caller;
             ExecutionThread met;
+            MessagePriority mpriority;
         };
     }
 }
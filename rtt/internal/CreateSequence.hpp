@@ -74,7 +74,7 @@ namespace RTT
          */
         template<class Seq, class Data, class Enable = void >
         struct GetArgument {
-            Data operator()(Seq s) { bf::front(s)->evaluate(); return Data(bf::front(s)->rvalue()); /* front(s) is a DataSource<Data> */}
+            Data operator()(const Seq& s) { bf::front(s)->evaluate(); return Data(bf::front(s)->rvalue()); /* front(s) is a DataSource<Data> */}
         }; // normal type
 
         /**
@@ -82,7 +82,7 @@ namespace RTT
          */
         template<class Seq, class Data>
         struct GetArgument<Seq, Data, typename boost::enable_if< is_pure_reference<Data> >::type> {
-            Data operator()(Seq s) { return Data(bf::front(s)->set() ); /* Case of reference.*/ }
+            Data operator()(const Seq& s) { return Data(bf::front(s)->set() ); /* Case of reference.*/ }
         }; // shared_ptr type
 
         /**
@@ -104,12 +104,12 @@ namespace RTT
          */
         template<class T>
         struct UpdateHelper {
-            static void update(typename DataSource<typename remove_cr<T>::type >::shared_ptr) {}
+            static void update(const typename DataSource<typename remove_cr<T>::type >::shared_ptr&) {}
         };
 
         template<class T>
         struct UpdateHelper<T&> {
-            static void update(typename DataSource<typename remove_cr<T>::type >::shared_ptr s) { s->updated(); }
+            static void update(const typename DataSource<typename remove_cr<T>::type >::shared_ptr& s) { s->updated(); }
         };
 
         /**
@@ -268,7 +268,8 @@ namespace RTT
              * @return A sequence of type T holding the values of the DataSource<T>.
              */
             static data_type data(const type& seq) {
-                return data_type( GetArgument<type,arg_type>()(seq), tail::data( bf::pop_front(seq) ) );
+                // recurse on the tail in place, such that no data source references are copied.
+                return data_type( GetArgument<type,arg_type>()(seq), tail::data( seq.cdr ) );
             }
 
             /**
@@ -288,8 +289,8 @@ namespace RTT
              * @param seq A sequence of DataSource<T> objects
              */
             static void update(const type&seq) {
-                UpdateHelper<arg_type>::update( bf::front(seq) );
-                return tail::update( bf::pop_front(seq) );
+                UpdateHelper<arg_type>::update( seq.car );
+                return tail::update( seq.cdr );
             }
 
             /**
@@ -551,7 +551,7 @@ namespace RTT
             typename FusedMSignal<Signature>::shared_ptr cloneRT() const
             {
                 // returns identical copy of this;
-                return boost::allocate_shared<FusedMSignal<Signature> >(os::rt_allocator<FusedMSignal<Signature> >(), *this);
+                return boost::allocate_shared<FusedMSignal<Signature> >(os::rt_subsystem_allocator<FusedMSignal<Signature>, os::MemoryOperations>(), *this);
             }
         };
 
@@ -0,0 +1,331 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef ORO_LIST_COPY_ON_WRITE_HPP
+#define ORO_LIST_COPY_ON_WRITE_HPP
+
+#include <vector>
+#include <algorithm>
+#include "../os/oro_arch.h"
+#include "../os/CAS.hpp"
+#include "../os/Mutex.hpp"
+#include "../os/MutexLock.hpp"
+
+namespace RTT
+{ namespace internal {
+
+    /**
+     * A copy-on-write list which allows any number of threads to
+     * iterate over its contents without locking and without allocating,
+     * while other threads \a append or \a erase items.
+     *
+     * Readers (apply()) increment the reader count of the currently
+     * published snapshot, check that it is still the published one and
+     * walk it. Writers are serialized by a mutex, build a new snapshot,
+     * publish it with a compare-and-swap and retire the previous one. A
+     * retired snapshot is recycled as soon as its own reader count drops
+     * to zero, so apply() never sees a snapshot being modified. Unlike
+     * ListLockFree, the cost of apply() does not depend on the number of
+     * threads (ORONUM_OS_MAX_THREADS) nor on concurrent modifications.
+     *
+     * Snapshots are recycled, so after reserve() or a few grow() calls,
+     * \a append and \a erase do not allocate either, as long as the
+     * number of items does not exceed the reserved capacity. Readers only
+     * hold back the snapshot they are walking, so no more snapshots are
+     * retired than there are threads in apply() at the same time, even if
+     * the list is read without interruption.
+     *
+     * @param T The value type to be stored in the list. It must be
+     * default constructible and comparable with operator==.
+     * @ingroup CoreLibBuffers
+     */
+    template< class T>
+    class ListCopyOnWrite
+    {
+    public:
+        typedef T value_t;
+    private:
+        struct Snapshot {
+            Snapshot(size_t cap) : size(0), capacity(cap), items( new T[cap] ) { oro_atomic_set(&readers, 0); }
+            ~Snapshot() { delete[] items; }
+            size_t size;
+            size_t capacity;
+            T*     items;
+            oro_atomic_t readers;
+        };
+
+        Snapshot* volatile active;
+        size_t required;
+        os::Mutex wlock;
+        /**
+         * Snapshots which were published before and may still be read.
+         */
+        std::vector<Snapshot*> retired;
+        /**
+         * Snapshots which are no longer read and can be written to.
+         */
+        std::vector<Snapshot*> spares;
+
+        /**
+         * Returns the published snapshot, after registering the caller
+         * as one of its readers. Call leave() when done.
+         */
+        Snapshot* enter() const {
+            while (true) {
+                Snapshot* s = active;
+                oro_atomic_inc(&s->readers);
+                // a writer which retired \a s in the mean time may recycle it.
+                if ( s == active )
+                    return s;
+                oro_atomic_dec(&s->readers);
+            }
+        }
+
+        void leave(Snapshot* s) const {
+            oro_atomic_dec(&s->readers);
+        }
+
+        /**
+         * Moves the retired snapshots which are not read to the spares.
+         * Writer lock must be held.
+         */
+        void reclaim() {
+            for (typename std::vector<Snapshot*>::iterator it = retired.begin(); it != retired.end(); )
+                if ( oro_atomic_read(&(*it)->readers) == 0 ) {
+                    // release the copies we hold, such that shared items can be freed.
+                    std::fill( (*it)->items, (*it)->items + (*it)->size, T() );
+                    (*it)->size = 0;
+                    spares.push_back( *it );
+                    it = retired.erase(it);
+                } else
+                    ++it;
+        }
+
+        /**
+         * Returns an empty snapshot which can hold \a items items.
+         * Writer lock must be held.
+         */
+        Snapshot* acquire(size_t items) {
+            reclaim();
+            for (typename std::vector<Snapshot*>::iterator it = spares.begin(); it != spares.end(); ++it)
+                if ( (*it)->capacity >= items ) {
+                    Snapshot* s = *it;
+                    spares.erase(it);
+                    return s;
+                }
+            return new Snapshot( std::max(items, required) );
+        }
+
+        /**
+         * Publishes \a next and retires the current snapshot.
+         * Writer lock must be held.
+         */
+        void publish(Snapshot* next) {
+            Snapshot* orig = active;
+            os::CAS(&active, orig, next); // only fails if we have a bug in our locking.
+            retired.push_back( orig );
+            reclaim();
+        }
+
+        /**
+         * Makes sure that enough snapshots of size \a required exist such
+         * that append() and erase() do not allocate.
+         * Writer lock must be held.
+         */
+        void provision() {
+            // At most three snapshots exist at the same time in steady state:
+            // the active one, one retired being read and one spare.
+            retired.reserve(3);
+            spares.reserve(3);
+            reclaim();
+            size_t enough = 0;
+            for (typename std::vector<Snapshot*>::iterator it = spares.begin(); it != spares.end(); )
+                if ( (*it)->capacity >= required ) {
+                    ++enough;
+                    ++it;
+                } else {
+                    // too small to be of further use.
+                    delete *it;
+                    it = spares.erase(it);
+                }
+            while ( enough < 2 ) {
+                spares.push_back( new Snapshot(required) );
+                ++enough;
+            }
+        }
+
+        ListCopyOnWrite(const ListCopyOnWrite&);
+        ListCopyOnWrite& operator=(const ListCopyOnWrite&);
+    public:
+        /**
+         * Create a list which can hold \a lsize items without
+         * allocating memory.
+         */
+        ListCopyOnWrite(size_t lsize)
+            : active( new Snapshot(lsize) ), required(lsize)
+        {
+            os::MutexLock lock(wlock);
+            provision();
+        }
+
+        ~ListCopyOnWrite() {
+            // no readers or writers may be present at this point.
+            for (typename std::vector<Snapshot*>::iterator it = retired.begin(); it != retired.end(); ++it)
+                delete *it;
+            for (typename std::vector<Snapshot*>::iterator it = spares.begin(); it != spares.end(); ++it)
+                delete *it;
+            delete active;
+        }
+
+        size_t capacity() const
+        {
+            return required;
+        }
+
+        size_t size() const
+        {
+            Snapshot* s = enter();
+            size_t res = s->size;
+            leave(s);
+            return res;
+        }
+
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        /**
+         * Grow the capacity to contain at least \a items additional items.
+         * This method will allocate memory if no spare snapshots of that
+         * capacity are available.
+         */
+        void grow(size_t items = 1) {
+            os::MutexLock lock(wlock);
+            required += items;
+            provision();
+        }
+
+        /**
+         * Shrink the capacity with at most \a items items. Memory is
+         * not freed, snapshots are kept for re-use.
+         */
+        void shrink(size_t items = 1) {
+            os::MutexLock lock(wlock);
+            required -= std::min(items, required);
+        }
+
+        /**
+         * Reserve a capacity for this list.
+         * @param lsize the \a minimal number of items this list will be
+         * able to hold. Will not drop below the current capacity.
+         */
+        void reserve(size_t lsize)
+        {
+            os::MutexLock lock(wlock);
+            if ( lsize <= required )
+                return;
+            required = lsize;
+            provision();
+        }
+
+        /**
+         * Removes all items from the list.
+         */
+        void clear()
+        {
+            os::MutexLock lock(wlock);
+            publish( acquire(0) );
+        }
+
+        /**
+         * Append a single value to the list.
+         * @param item the value to write
+         * @return true, this list never runs out of space.
+         */
+        bool append( value_t item )
+        {
+            os::MutexLock lock(wlock);
+            Snapshot* orig = active;
+            Snapshot* next = acquire( orig->size + 1 );
+            std::copy( orig->items, orig->items + orig->size, next->items );
+            next->items[orig->size] = item;
+            next->size = orig->size + 1;
+            publish(next);
+            return true;
+        }
+
+        /**
+         * Returns the first element of the list.
+         */
+        value_t front() const
+        {
+            Snapshot* s = enter();
+            value_t ret = s->size ? s->items[0] : value_t();
+            leave(s);
+            return ret;
+        }
+
+        /**
+         * Erase a value from the list.
+         * @param item is to be erased from the list.
+         * @return true if found and erased.
+         */
+        bool erase( value_t item )
+        {
+            os::MutexLock lock(wlock);
+            Snapshot* orig = active;
+            T* found = std::find( orig->items, orig->items + orig->size, item );
+            if ( found == orig->items + orig->size )
+                return false;
+            Snapshot* next = acquire( orig->size - 1 );
+            T* out = std::copy( orig->items, found, next->items );
+            std::copy( found + 1, orig->items + orig->size, out );
+            next->size = orig->size - 1;
+            publish(next);
+            return true;
+        }
+
+        /**
+         * Apply a function to all items of the list. Items appended
+         * or erased during apply() are not seen by this call.
+         * @param func The function to apply.
+         */
+        template<class Function>
+        void apply(Function func )
+        {
+            Snapshot* s = enter();
+            for (T* it = s->items; it != s->items + s->size; ++it)
+                func( *it );
+            leave(s);
+        }
+    };
+}}
+
+#endif
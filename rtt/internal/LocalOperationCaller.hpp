@@ -104,7 +104,7 @@ namespace RTT
                         this->reportError();
                     bool result = false;
                     if ( this->caller){
-                        result = this->caller->process(this);
+                        result = this->caller->process(this, this->mpriority);
                     }
                     if (!result)
                         dispose();
@@ -131,7 +131,7 @@ namespace RTT
                 //std::cout << "Sending clone..."<<std::endl;
                 ExecutionEngine* receiver = this->getMessageProcessor();
                 cl->self = cl;
-                if ( receiver && receiver->process( cl.get() ) ) {
+                if ( receiver && receiver->process( cl.get(), cl->getPriority() ) ) {
                     return SendHandle<Signature>( cl );
                 } else {
                     cl->dispose();
@@ -705,7 +705,7 @@ namespace RTT
             typename LocalOperationCallerImpl<Signature>::shared_ptr cloneRT() const
             {
                 // returns identical copy of this;
-                return boost::allocate_shared<LocalOperationCaller<Signature> >(os::rt_allocator<LocalOperationCaller<Signature> >(), *this);
+                return boost::allocate_shared<LocalOperationCaller<Signature> >(os::rt_subsystem_allocator<LocalOperationCaller<Signature>, os::MemoryOperations>(), *this);
             }
         };
     }
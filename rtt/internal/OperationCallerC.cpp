@@ -42,6 +42,7 @@
 #include "../Service.hpp"
 #include "../Logger.hpp"
 #include "Exceptions.hpp"
+#include "../types/TypeInfo.hpp"
 #include <vector>
 
 namespace RTT {
@@ -88,7 +89,12 @@ namespace RTT {
         void newarg(DataSourceBase::shared_ptr na)
         {
             this->args.push_back( na );
-            this->checkAndCreate();
+            try {
+                this->checkAndCreate();
+            } catch(...) {
+                this->args.pop_back();
+                throw;
+            }
         }
 
         void ret(AttributeBase* r)
@@ -139,7 +145,7 @@ namespace RTT {
     }
 
     OperationCallerC::OperationCallerC(const OperationCallerC& other)
-        : d( other.d ? new D(*other.d) : 0 ), m( other.m ? other.m : 0), s( other.s ? other.s : 0), ofp(other.ofp), mname(other.mname)
+        : d( other.d ? new D(*other.d) : 0 ), m( other.m ? other.m : 0), s( other.s ? other.s : 0), ofp(other.ofp), mname(other.mname), margs(other.margs)
     {
     }
 
@@ -148,6 +154,7 @@ namespace RTT {
     {
         if ( d ) {
             d->caller = caller;
+            margs = other.margs;
         } else {
             d = new D(other.ofp, other.mname, caller);
         }
@@ -163,6 +170,7 @@ namespace RTT {
         s = other.s;
         ofp = other.ofp;
         mname = other.mname;
+        margs = other.margs;
         return *this;
     }
 
@@ -173,9 +181,11 @@ namespace RTT {
 
     OperationCallerC& OperationCallerC::arg( DataSourceBase::shared_ptr a )
     {
-        if (d)
+        if (d) {
+            // newarg() throws on a wrong argument, which must not be kept.
             d->newarg( a );
-        else {
+            margs.push_back( a );
+        } else {
             Logger::log() <<Logger::Warning << "Extra argument discarded for OperationCallerC."<<Logger::endl;
         }
         if ( d && d->m ) {
@@ -187,6 +197,28 @@ namespace RTT {
         return *this;
     }
 
+    OperationCallerC& OperationCallerC::bindArguments()
+    {
+        if ( !d || !d->ofp )
+            return *this;
+        size_t sz = d->ofp->arity();
+        for ( size_t i = d->args.size(); d && i != sz; ++i) {
+            const types::TypeInfo* ti = d->ofp->getArgumentType( i + 1 );
+            DataSourceBase::shared_ptr a = ti ? ti->buildValue() : DataSourceBase::shared_ptr();
+            if ( !a ) {
+                log(Error) << "Can not bind argument "<< i + 1 <<" of operation '"<< mname <<"': no value storage for its type."<<endlog();
+                break;
+            }
+            this->arg( a );
+        }
+        return *this;
+    }
+
+    const std::vector<DataSourceBase::shared_ptr>& OperationCallerC::getArguments() const
+    {
+        return margs;
+    }
+
     OperationCallerC& OperationCallerC::ret( AttributeBase* r )
     {
         if (d)
@@ -40,6 +40,7 @@
 #define ORO_EXECUTION_METHODC_HPP
 
 #include <string>
+#include <vector>
 #include "DataSources.hpp"
 #include "../Attribute.hpp"
 #include "../rtt-fwd.hpp"
@@ -63,6 +64,7 @@ namespace RTT
         base::DataSourceBase::shared_ptr s;
         OperationInterfacePart* ofp;
         std::string mname;
+        std::vector<base::DataSourceBase::shared_ptr> margs;
 
     public:
         /**
@@ -125,6 +127,21 @@ namespace RTT
             return this->arg(base::DataSourceBase::shared_ptr( new ReferenceDataSource<ArgT>( a ) ) );
         }
 
+        /**
+         * Add value storage for all remaining arguments of the OperationCaller.
+         * The operation is then looked up and produced only once, while
+         * call() and send() can be repeated with new argument values, written
+         * into the storage returned by getArguments().
+         * @see types::TypeInfo::buildValue()
+         */
+        OperationCallerC& bindArguments();
+
+        /**
+         * Returns the data sources of all arguments that were added
+         * to this OperationCaller, in order.
+         */
+        const std::vector<base::DataSourceBase::shared_ptr>& getArguments() const;
+
         /**
          * Store the result of the method in a task's attribute.
          * @param r A task attribute in which the result is stored.
@@ -39,7 +39,7 @@
 #include "SignalBase.hpp"
 #include <boost/bind.hpp>
 
-#ifdef ORO_SIGNAL_USE_LIST_LOCK_FREE
+#ifdef ORO_SIGNAL_USE_LIST_COPY_ON_WRITE
 #else
 #include "../os/MutexLock.hpp"
 #endif
@@ -87,7 +87,7 @@ namespace RTT {
 
         void SignalBase::conn_setup( connection_t conn ) {
             // allocate empty slot in list.
-#ifdef ORO_SIGNAL_USE_LIST_LOCK_FREE
+#ifdef ORO_SIGNAL_USE_LIST_COPY_ON_WRITE
             mconnections.grow(1);
 #else
 #ifdef ORO_SIGNAL_USE_RT_LIST
@@ -103,7 +103,7 @@ namespace RTT {
         void SignalBase::conn_connect( connection_t conn ) {
             assert( conn.get() && "virtually impossible ! only connection base should call this function !" );
 
-#ifdef ORO_SIGNAL_USE_LIST_LOCK_FREE
+#ifdef ORO_SIGNAL_USE_LIST_COPY_ON_WRITE
             mconnections.append( conn );
 #else
             // derived class must make sure that list contained enough list items !
@@ -130,7 +130,7 @@ namespace RTT {
         void SignalBase::conn_destroy( connection_t conn ) {
             this->conn_disconnect(conn);
             // increase number of connections destroyed.
-#ifdef ORO_SIGNAL_USE_LIST_LOCK_FREE
+#ifdef ORO_SIGNAL_USE_LIST_COPY_ON_WRITE
             // free memory
             mconnections.shrink(1);
 #else
@@ -146,7 +146,7 @@ namespace RTT {
         void SignalBase::conn_disconnect( connection_t conn ) {
             assert( conn.get() && "virtually impossible ! only connection base should call this function !" );
 
-#ifdef ORO_SIGNAL_USE_LIST_LOCK_FREE
+#ifdef ORO_SIGNAL_USE_LIST_COPY_ON_WRITE
             mconnections.erase( conn );
 #else
             iterator tgt;
@@ -170,7 +170,7 @@ namespace RTT {
 #endif
         }
 
-#ifdef ORO_SIGNAL_USE_LIST_LOCK_FREE
+#ifdef ORO_SIGNAL_USE_LIST_COPY_ON_WRITE
             // NOP
 #else
         void SignalBase::cleanup() {
@@ -208,7 +208,7 @@ namespace RTT {
 #endif
 
         SignalBase::SignalBase() :
-#ifdef ORO_SIGNAL_USE_LIST_LOCK_FREE
+#ifdef ORO_SIGNAL_USE_LIST_COPY_ON_WRITE
             mconnections(4) // this is a 'sane' starting point, this number will be grown if required.
 #else
 #ifdef ORO_SIGNAL_USE_RT_LIST
@@ -219,7 +219,7 @@ namespace RTT {
 #endif
             ,emitting(false)
     {
-#ifdef ORO_SIGNAL_USE_LIST_LOCK_FREE
+#ifdef ORO_SIGNAL_USE_LIST_COPY_ON_WRITE
         // NOP
 #else
         itend = mconnections.end();
@@ -231,14 +231,14 @@ namespace RTT {
             destroy();
         }
 
-#ifdef ORO_SIGNAL_USE_LIST_LOCK_FREE
+#ifdef ORO_SIGNAL_USE_LIST_COPY_ON_WRITE
         static void disconnectImpl( const ConnectionBase::shared_ptr& c ) {
             c->disconnect();
         }
 #endif
 
         void SignalBase::disconnect() {
-#ifdef ORO_SIGNAL_USE_LIST_LOCK_FREE
+#ifdef ORO_SIGNAL_USE_LIST_COPY_ON_WRITE
             mconnections.apply( boost::bind(&disconnectImpl, _1 ) );
 #else
             // avoid invalidating iterator
@@ -252,7 +252,7 @@ namespace RTT {
             while ( !mconnections.empty() ) {
                 if ( mconnections.front() )
                     mconnections.front()->destroy(); // this calls-back conn_disconnect.
-#ifdef ORO_SIGNAL_USE_LIST_LOCK_FREE
+#ifdef ORO_SIGNAL_USE_LIST_COPY_ON_WRITE
                 // NOP
 #else
 #ifdef ORO_SIGNAL_USE_RT_LIST
@@ -265,7 +265,7 @@ namespace RTT {
         }
 
         void SignalBase::reserve( size_t conns ) {
-#ifdef ORO_SIGNAL_USE_LIST_LOCK_FREE
+#ifdef ORO_SIGNAL_USE_LIST_COPY_ON_WRITE
             mconnections.reserve( conns );
 #endif
         }
@@ -47,12 +47,12 @@
 #if defined(OROBLD_OS_NO_ASM)
 #define ORO_SIGNAL_USE_RT_LIST
 #else
-#define ORO_SIGNAL_USE_LIST_LOCK_FREE
+#define ORO_SIGNAL_USE_LIST_COPY_ON_WRITE
 #endif
 
 #include "../os/Atomic.hpp"
-#ifdef ORO_SIGNAL_USE_LIST_LOCK_FREE
-#include "ListLockFree.hpp"
+#ifdef ORO_SIGNAL_USE_LIST_COPY_ON_WRITE
+#include "ListCopyOnWrite.hpp"
 #include <boost/shared_ptr.hpp>
 #else
 #ifdef ORO_SIGNAL_USE_RT_LIST
@@ -123,14 +123,17 @@ namespace RTT
          * The base signal class which stores connection objects.
          * It implements real-time management of connections, such that
          * connection/disconnetion of a handler is always thread-safe
-         * and real-time.
+         * and real-time. Unless the target lacks atomic instructions,
+         * emitting walks a copy-on-write snapshot of the connections,
+         * which does not lock nor allocate, whatever the number of
+         * threads connecting or disconnecting concurrently.
          */
         class RTT_API SignalBase
         {
         public:
             typedef ConnectionBase::shared_ptr        connection_t;
-#ifdef ORO_SIGNAL_USE_LIST_LOCK_FREE
-            typedef ListLockFree<connection_t> connections_list;
+#ifdef ORO_SIGNAL_USE_LIST_COPY_ON_WRITE
+            typedef ListCopyOnWrite<connection_t> connections_list;
 #else
 #ifdef ORO_SIGNAL_USE_RT_LIST
             typedef RTT::os::rt_list< connection_t >    connections_list;
@@ -152,7 +155,7 @@ namespace RTT
             void conn_destroy( connection_t conn );
         protected:
             connections_list mconnections;
-#ifdef ORO_SIGNAL_USE_LIST_LOCK_FREE
+#ifdef ORO_SIGNAL_USE_LIST_COPY_ON_WRITE
             // no mutexes involved
 #else
             /**
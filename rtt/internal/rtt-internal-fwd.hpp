@@ -29,6 +29,8 @@ namespace RTT {
         template< class T>
         class List;
         template< class T>
+        class ListCopyOnWrite;
+        template< class T>
         class ListLockFree;
         template< class T>
         class ListLocked;
@@ -42,7 +42,7 @@
 #include "SignalBase.hpp"
 #include "NA.hpp"
 
-#ifdef ORO_SIGNAL_USE_LIST_LOCK_FREE
+#ifdef ORO_SIGNAL_USE_LIST_COPY_ON_WRITE
 #include <boost/bind.hpp>
 #else
 #include "../os/MutexLock.hpp"
@@ -134,7 +134,7 @@ namespace RTT {
     public:
 		R emit(OROCOS_SIGNATURE_PARMS)
 		{
-#ifdef ORO_SIGNAL_USE_LIST_LOCK_FREE
+#ifdef ORO_SIGNAL_USE_LIST_COPY_ON_WRITE
             this->emitting = true;
 
             // this code did initially not work under gcc 4.0/ubuntu breezy.
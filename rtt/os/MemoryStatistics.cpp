@@ -0,0 +1,135 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "MemoryStatistics.hpp"
+#include "CAS.hpp"
+#if defined(OS_RT_MALLOC) && defined(OS_RT_MALLOC_STATS)
+#define ORO_MEMORY_POOL
+#include "tlsf/tlsf.h"
+#endif
+
+namespace RTT
+{ namespace os {
+
+    namespace {
+        struct MemoryCounters {
+            volatile std::size_t bytes;
+            volatile std::size_t blocks;
+            volatile std::size_t peak;
+            volatile std::size_t failures;
+        };
+
+        MemoryCounters subsystems[MemorySubsystems];
+
+        /**
+         * Adds \a delta to \a counter and returns the new value.
+         */
+        std::size_t add(volatile std::size_t& counter, std::size_t delta)
+        {
+            std::size_t orig;
+            do {
+                orig = counter;
+            } while ( !CAS(&counter, orig, orig + delta) );
+            return orig + delta;
+        }
+
+        void raise(volatile std::size_t& counter, std::size_t value)
+        {
+            std::size_t orig;
+            do {
+                orig = counter;
+            } while ( value > orig && !CAS(&counter, orig, value) );
+        }
+
+#if defined(OS_RT_MALLOC) && defined(OS_RT_MALLOC_STATS)
+        MemoryUsage poolUsage(void* pool)
+        {
+            MemoryUsage usage;
+            if ( pool ) {
+                usage.bytes = get_used_size(pool);
+                usage.blocks = get_used_blocks(pool);
+                usage.peak = get_max_size(pool);
+                usage.failures = get_failed_count(pool);
+            }
+            return usage;
+        }
+#endif
+    }
+
+    MemoryUsage getMemoryPoolUsage()
+    {
+        MemoryUsage usage;
+#if defined(OS_RT_MALLOC) && defined(OS_RT_MALLOC_STATS)
+        usage.bytes = get_used_size_mp();
+        usage.blocks = get_used_blocks_mp();
+        usage.peak = get_max_size_mp();
+        usage.failures = get_failed_count_mp();
+#endif
+        return usage;
+    }
+
+    MemoryUsage getThreadMemoryUsage()
+    {
+#if defined(OS_RT_MALLOC) && defined(OS_RT_MALLOC_STATS)
+        return poolUsage( get_arena_pool_self() );
+#else
+        return MemoryUsage();
+#endif
+    }
+
+    MemoryUsage getSubsystemMemoryUsage(MemorySubsystem subsystem)
+    {
+        MemoryUsage usage;
+        if ( subsystem < MemoryOther || subsystem >= MemorySubsystems )
+            return usage;
+        usage.bytes = subsystems[subsystem].bytes;
+        usage.blocks = subsystems[subsystem].blocks;
+        usage.peak = subsystems[subsystem].peak;
+        usage.failures = subsystems[subsystem].failures;
+        return usage;
+    }
+
+    void memoryAllocated(MemorySubsystem subsystem, std::size_t bytes, bool success)
+    {
+        MemoryCounters& c = subsystems[subsystem];
+        if ( !success ) {
+            add( c.failures, 1 );
+            return;
+        }
+        add( c.blocks, 1 );
+        raise( c.peak, add( c.bytes, bytes ) );
+    }
+
+    void memoryFreed(MemorySubsystem subsystem, std::size_t bytes)
+    {
+        MemoryCounters& c = subsystems[subsystem];
+        add( c.blocks, std::size_t(-1) );
+        add( c.bytes, std::size_t(0) - bytes );
+    }
+}}
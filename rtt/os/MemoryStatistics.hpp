@@ -0,0 +1,123 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef ORO_OS_MEMORY_STATISTICS_HPP
+#define ORO_OS_MEMORY_STATISTICS_HPP
+
+#include <cstddef>
+#include "../rtt-config.h"
+
+namespace RTT
+{ namespace os {
+
+    /**
+     * The users of the real-time memory pool which are accounted
+     * for separately. Memory is attributed to a subsystem by the
+     * second template argument of rt_subsystem_allocator.
+     */
+    enum MemorySubsystem {
+        //! Memory not attributed to any subsystem.
+        MemoryOther,
+        //! Asynchronous operation calls and operation signals.
+        MemoryOperations,
+        //! rt_string and rt_ostringstream.
+        MemoryStrings,
+        //! Free for use by user components.
+        MemoryUser,
+        //! The number of subsystems.
+        MemorySubsystems
+    };
+
+    /**
+     * The usage of (a part of) the real-time memory pool.
+     */
+    struct RTT_API MemoryUsage
+    {
+        MemoryUsage() : bytes(0), blocks(0), peak(0), failures(0) {}
+        /**
+         * The number of bytes in use.
+         */
+        std::size_t bytes;
+        /**
+         * The number of blocks in use.
+         */
+        std::size_t blocks;
+        /**
+         * The highest number of bytes that was in use at any time.
+         */
+        std::size_t peak;
+        /**
+         * The number of allocations that failed.
+         */
+        std::size_t failures;
+    };
+
+    /**
+     * Returns the usage of the default real-time memory pool. This
+     * includes the bookkeeping of the allocator and, if
+     * OS_RT_MALLOC_ARENAS is set, the arenas of all threads.
+     * Returns an empty usage unless OS_RT_MALLOC and OS_RT_MALLOC_STATS
+     * are set.
+     */
+    RTT_API MemoryUsage getMemoryPoolUsage();
+
+    /**
+     * Returns the usage of the real-time memory pool the calling thread
+     * allocates from. This is the thread's own arena if OS_RT_MALLOC_ARENAS
+     * is set and the default pool otherwise.
+     * Returns an empty usage unless OS_RT_MALLOC and OS_RT_MALLOC_STATS
+     * are set.
+     */
+    RTT_API MemoryUsage getThreadMemoryUsage();
+
+    /**
+     * Returns the memory \a subsystem requested from the real-time memory
+     * pool through rt_subsystem_allocator, without the allocator's overhead.
+     * Returns an empty usage unless OS_RT_MALLOC and
+     * OS_RT_MALLOC_SUBSYSTEM_STATS are set. That option is off by default
+     * because every rt_subsystem_allocator call then updates counters which are
+     * shared by all threads.
+     */
+    RTT_API MemoryUsage getSubsystemMemoryUsage(MemorySubsystem subsystem);
+
+    /**
+     * Accounts an allocation of \a bytes by \a subsystem, or a failed
+     * attempt if \a success is false. Called by rt_subsystem_allocator if
+     * OS_RT_MALLOC_SUBSYSTEM_STATS is set. This function is lock-free.
+     */
+    RTT_API void memoryAllocated(MemorySubsystem subsystem, std::size_t bytes, bool success);
+
+    /**
+     * Accounts that \a subsystem freed \a bytes. Called by rt_subsystem_allocator if
+     * OS_RT_MALLOC_SUBSYSTEM_STATS is set. This function is lock-free.
+     */
+    RTT_API void memoryFreed(MemorySubsystem subsystem, std::size_t bytes);
+}}
+
+#endif
@@ -69,6 +69,28 @@ namespace RTT
 	};
 
 
+    /**
+     * Selects how a Mutex waits when it is locked by another thread.
+     */
+    enum MutexPolicy {
+        /**
+         * Use the default of this build, which is AdaptiveMutexPolicy
+         * if OS_MUTEX_ADAPTIVE was set and BlockingMutexPolicy otherwise.
+         */
+        DefaultMutexPolicy,
+        /**
+         * Block immediately, with priority inheritance if OS_MUTEX_PRIO_INHERIT
+         * was set. Use this for mutexes shared with real-time threads.
+         */
+        BlockingMutexPolicy,
+        /**
+         * Spin a short while before blocking. This is faster for very short
+         * critical sections which are contended by threads running on other
+         * CPUs, but does not offer priority inheritance.
+         */
+        AdaptiveMutexPolicy
+    };
+
     /**
      * @brief An object oriented wrapper around a non recursive mutex.
      *
@@ -91,7 +113,28 @@ namespace RTT
 	    */
 	    Mutex()
 	    {
+#ifdef OS_MUTEX_ADAPTIVE
+	        rtos_mutex_init_adaptive( &m);
+#else
 	        rtos_mutex_init( &m);
+#endif
+	    }
+
+	    /**
+	    * Initialize a Mutex with a given policy.
+	    * @param policy How to wait for the mutex if it is locked. Targets
+	    * which can not spin ignore AdaptiveMutexPolicy.
+	    */
+	    explicit Mutex(MutexPolicy policy)
+	    {
+#ifdef OS_MUTEX_ADAPTIVE
+	        if ( policy == DefaultMutexPolicy )
+	            policy = AdaptiveMutexPolicy;
+#endif
+	        if ( policy == AdaptiveMutexPolicy )
+	            rtos_mutex_init_adaptive( &m );
+	        else
+	            rtos_mutex_init( &m );
 	    }
 
 	    /**
@@ -153,6 +196,14 @@ namespace RTT
         {
         }
 
+        /**
+        * Initialize a Mutex. The policy is ignored,
+        * boost mutexes are always blocking.
+        */
+        explicit Mutex(MutexPolicy)
+        {
+        }
+
         /**
         * Destroy a Mutex.
         * If the Mutex is still locked, the RTOS
@@ -18,10 +18,95 @@
 
 #include "os/fosi.h"
 #include "TimeService.hpp"
+#include "CAS.hpp"
+
+#if defined(OROPKG_OS_GNULINUX) && !defined(OROBLD_OS_NO_ASM) && (defined(__i386__) || defined(__x86_64__))
+#define ORO_TIME_FAST_CLOCK
+#include <cpuid.h>
+#include <fstream>
+#include <string>
+#endif
 
 namespace RTT {
     using namespace os;
 
+#ifdef ORO_TIME_FAST_CLOCK
+    namespace {
+        inline unsigned long long read_tsc()
+        {
+            unsigned int lo, hi;
+            __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+            return ( (unsigned long long)hi << 32 ) | lo;
+        }
+
+        /**
+         * The time stamp counter is only usable as a clock if it runs
+         * at a constant rate in all power states and is synchronised
+         * over all cpus. The kernel verifies the latter before it selects
+         * the TSC as clocksource.
+         */
+        bool has_invariant_tsc()
+        {
+            unsigned int eax, ebx, ecx, edx;
+            if ( __get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0 || eax < 0x80000007 )
+                return false;
+            __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+            if ( (edx & (1u << 8)) == 0 )
+                return false;
+            std::ifstream clocksource("/sys/devices/system/clocksource/clocksource0/current_clocksource");
+            std::string name;
+            clocksource >> name;
+            return name == "tsc";
+        }
+
+        /**
+         * Reads the TSC and the system clock as close together as
+         * possible. The TSC value returned is the middle of the
+         * shortest of a few attempts.
+         */
+        void sample_tsc(unsigned long long& tsc, long long& ns)
+        {
+            unsigned long long shortest = ~0ULL;
+            for (int i = 0; i != 5; ++i) {
+                unsigned long long before = read_tsc();
+                long long now = rtos_get_time_ns();
+                unsigned long long after = read_tsc();
+                if ( after - before < shortest ) {
+                    shortest = after - before;
+                    tsc = before + shortest / 2;
+                    ns = now;
+                }
+            }
+        }
+
+        /**
+         * Keeps the compiler from moving memory accesses across it. The
+         * cpu itself does not reorder loads with loads, nor stores with
+         * stores, on x86.
+         */
+        inline void compiler_barrier()
+        {
+            __asm__ __volatile__ ("" ::: "memory");
+        }
+
+        inline long long scale_tsc(unsigned long long delta, unsigned long long mult)
+        {
+            // mult < 2^32, so neither product overflows.
+            return (delta >> 32) * mult + ( ( (delta & 0xffffffffULL) * mult ) >> 32 );
+        }
+
+        /**
+         * The time after which the fast clock is re-anchored, in nsecs.
+         */
+        const long long FastClockPeriod = 1000000000LL;
+
+        inline unsigned long long period_tsc(unsigned long long mult)
+        {
+            return ( (unsigned long long)FastClockPeriod << 32 ) / mult;
+        }
+    }
+#endif
+
     TimeService* TimeService::_instance = 0;
 
     const TimeService::ticks TimeService::InfiniteTicks = ::InfiniteTicks;
@@ -63,9 +148,18 @@ namespace RTT {
 
 
     TimeService::TimeService()
-        : offset(0), use_clock(true)
+        : offset(0), use_clock(true), use_fast(false), fast_sequence(0), fast_anchoring(0), rate_tsc(0), rate_nsecs(0)
     {
+        for (int i = 0; i != 2; ++i) {
+            fast_calibration[i].base = 0;
+            fast_calibration[i].tsc = 0;
+            fast_calibration[i].mult = 0;
+            fast_calibration[i].until = 0;
+        }
         //os::cout << "HeartBeat Created\n";
+#ifdef OS_FAST_CLOCK
+        enableFastClock(true);
+#endif
     }
 
     TimeService::~TimeService()
@@ -83,12 +177,12 @@ namespace RTT {
         if ( use_clock == true )
             {
                 // if offset is X, then start counting from X.
-                offset = offset - rtos_get_time_ticks();
+                offset = offset - systemTicks();
             }
         else
             {
                 // start counting from _now_ + old offset
-                offset = offset + rtos_get_time_ticks();
+                offset = offset + systemTicks();
             }
     }
 
@@ -97,10 +191,130 @@ namespace RTT {
       return use_clock;
     }
 
+    bool TimeService::enableFastClock( bool yes_no )
+    {
+        if ( yes_no == use_fast )
+            return use_fast;
+        if ( !yes_no ) {
+            use_fast = false;
+            return false;
+        }
+#ifdef ORO_TIME_FAST_CLOCK
+        if ( !has_invariant_tsc() )
+            return false;
+        // calibrate the TSC rate over 10ms.
+        unsigned long long tsc0 = 0, tsc1 = 0;
+        long long ns0 = 0, ns1 = 0;
+        sample_tsc(tsc0, ns0);
+        TIME_SPEC ts = ticks2timespec( nano2ticks( 10000000LL ) );
+        rtos_nanosleep( &ts, 0 );
+        sample_tsc(tsc1, ns1);
+        if ( tsc1 <= tsc0 || ns1 <= ns0 )
+            return false;
+        unsigned long long mult = ( (unsigned long long)(ns1 - ns0) << 32 ) / (tsc1 - tsc0);
+        // a TSC slower than 1GHz is not worth it, and would overflow scale_tsc.
+        if ( mult >= (1ULL << 32) )
+            return false;
+        FastCalibration& c = fast_calibration[fast_sequence & 1];
+        c.base = ns1;
+        c.tsc = tsc1;
+        c.mult = mult;
+        c.until = tsc1 + period_tsc( mult );
+        rate_tsc = tsc0;
+        rate_nsecs = ns0;
+        use_fast = true;
+#endif
+        return use_fast;
+    }
+
+    bool TimeService::fastClockEnabled() const
+    {
+        return use_fast;
+    }
+
+    TimeService::nsecs
+    TimeService::systemNSecs() const
+    {
+#ifdef ORO_TIME_FAST_CLOCK
+        if ( use_fast ) {
+            FastCalibration c;
+            unsigned int sequence;
+            do {
+                sequence = fast_sequence;
+                compiler_barrier();
+                c = fast_calibration[sequence & 1];
+                compiler_barrier();
+            } while ( sequence != fast_sequence );
+            unsigned long long tsc = read_tsc();
+            // Another cpu may be a few cycles behind the one we calibrated on.
+            if ( tsc <= c.tsc )
+                return c.base;
+            if ( tsc >= c.until )
+                return reanchorFastClock( tsc, c, sequence );
+            return c.base + scale_tsc( tsc - c.tsc, c.mult );
+        }
+#endif
+        return rtos_get_time_ns();
+    }
+
+#ifdef ORO_TIME_FAST_CLOCK
+    TimeService::nsecs
+    TimeService::reanchorFastClock( unsigned long long tsc, const FastCalibration& c, unsigned int sequence ) const
+    {
+        nsecs now = c.base + scale_tsc( tsc - c.tsc, c.mult );
+        // the other readers keep using the expired calibration meanwhile.
+        if ( !os::CAS( &fast_anchoring, 0, 1 ) )
+            return now;
+        if ( sequence != fast_sequence ) {
+            // another reader re-anchored since we looked.
+            os::CAS( &fast_anchoring, 1, 0 );
+            return now;
+        }
+
+        unsigned long long tsc1 = 0;
+        long long ns1 = 0;
+        sample_tsc( tsc1, ns1 );
+        if ( tsc1 < c.tsc )
+            tsc1 = c.tsc;
+        nsecs fast1 = c.base + scale_tsc( tsc1 - c.tsc, c.mult );
+        FastCalibration& n = fast_calibration[(sequence + 1) & 1];
+        // the rate is measured over all the time since it was calibrated,
+        // and the fast clock catches up with the offset it accumulated
+        // within the next period, instead of jumping to the system time.
+        double offset = double( ns1 - fast1 );
+        double mult = 0;
+        if ( tsc1 > rate_tsc && ns1 > rate_nsecs && offset < FastClockPeriod / 2 && offset > -FastClockPeriod / 2 )
+            mult = double( ns1 - rate_nsecs ) / double( tsc1 - rate_tsc ) * ( 1.0 + offset / FastClockPeriod ) * 4294967296.0;
+        if ( mult > 0 && mult < 4294967296.0 ) {
+            n.base = fast1;
+            n.mult = (unsigned long long)mult;
+        } else {
+            // the system clock was stepped: start over from it.
+            n.base = ns1;
+            n.mult = c.mult;
+            rate_tsc = tsc1;
+            rate_nsecs = ns1;
+        }
+        n.tsc = tsc1;
+        n.until = tsc1 + period_tsc( n.mult );
+        // publishes the new calibration after it was filled in.
+        compiler_barrier();
+        os::CAS( &fast_sequence, sequence, sequence + 1 );
+        os::CAS( &fast_anchoring, 1, 0 );
+        return now;
+    }
+#endif
+
+    TimeService::ticks
+    TimeService::systemTicks() const
+    {
+        return use_fast ? nano2ticks( systemNSecs() ) : rtos_get_time_ticks();
+    }
+
     TimeService::ticks
     TimeService::getTicks() const
     {
-        return use_clock ? rtos_get_time_ticks() + offset : 0 + offset;
+        return use_clock ? systemTicks() + offset : 0 + offset;
     }
 
     TimeService::ticks
@@ -150,7 +364,7 @@ namespace RTT {
     TimeService::nsecs
     TimeService::getNSecs() const
     {
-      return rtos_get_time_ns();
+      return systemNSecs();
     }
 
     TimeService::nsecs
@@ -175,6 +175,31 @@ namespace RTT
          */
         bool systemClockEnabled() const;
 
+        /**
+         * Enables or disables the fast clock. The fast clock reads the
+         * CPU's time stamp counter instead of calling into the system
+         * clock, which makes getTicks() and getNSecs() considerably
+         * cheaper. It is calibrated against and anchored to the system
+         * clock when enabled. Every second, the first reader re-anchors
+         * it, such that it follows the system clock's rate without
+         * jumping back in time.
+         *
+         * The fast clock is only used if the CPU has an invariant time
+         * stamp counter which the kernel also uses as its clocksource,
+         * otherwise the system clock remains in use. Enable it before
+         * other threads read the time, since the switch is not atomic
+         * with respect to these readers.
+         *
+         * @return true if the fast clock is used after this call.
+         */
+        bool enableFastClock( bool yes_no );
+
+        /**
+         * Check if the fast clock is being read.
+         * @return true if the time stamp counter is being used.
+         */
+        bool fastClockEnabled() const;
+
         /**
          * Get current nsecs of the System clock
          *
@@ -236,6 +261,60 @@ namespace RTT
         ticks offset;
 
         bool use_clock;
+
+        /**
+         * Returns the current system time in nsecs, read from
+         * the fast clock if enabled.
+         */
+        nsecs systemNSecs() const;
+
+        /**
+         * Returns the current system time in ticks, read from
+         * the fast clock if enabled.
+         */
+        ticks systemTicks() const;
+
+        bool use_fast;
+
+        /**
+         * Fast clock calibration: the system time equals
+         * base + (tsc - tsc) * mult / 2^32 nsecs, until the time stamp
+         * counter passes \a until and the calibration is re-anchored.
+         */
+        struct FastCalibration {
+            nsecs base;
+            unsigned long long tsc;
+            unsigned long long mult;
+            unsigned long long until;
+        };
+
+        /**
+         * Re-anchors the fast clock to the system clock, which is done
+         * by the first reader after the current calibration expired.
+         * @param tsc The time stamp counter read by this reader.
+         * @param c The expired calibration this reader copied.
+         * @param sequence The value of fast_sequence \a c was copied at.
+         * @return The fast clock time at \a tsc.
+         */
+        nsecs reanchorFastClock( unsigned long long tsc, const FastCalibration& c, unsigned int sequence ) const;
+
+        /**
+         * Readers use the calibration at fast_sequence % 2, while a
+         * re-anchor fills in the other one and then increments
+         * fast_sequence to publish it. A reader copies the calibration
+         * again if fast_sequence changed meanwhile, because the next
+         * re-anchor may then be rewriting the slot it copied.
+         */
+        mutable FastCalibration fast_calibration[2];
+        mutable volatile unsigned int fast_sequence;
+        mutable volatile int fast_anchoring;
+
+        /**
+         * The system clock sample from which the rate of the time
+         * stamp counter is measured.
+         */
+        mutable unsigned long long rate_tsc;
+        mutable nsecs rate_nsecs;
     };
 }} // namespace RTT
 
@@ -192,6 +192,12 @@ extern "C"
     return 0;
   }
 
+  static inline int rtos_mutex_init_adaptive(rt_mutex_t* m)
+  {
+    // eCos mutexes do not spin.
+    return rtos_mutex_init(m);
+  }
+
   static inline int rtos_mutex_destroy(rt_mutex_t* m )
   {
     cyg_mutex_release(m);
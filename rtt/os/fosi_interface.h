@@ -110,6 +110,9 @@ extern "C"
   typedef struct recursive_mutex_struct rt_rec_mutex_t;
 
   int rtos_mutex_init(rt_mutex_t* m);
+  // Same as rtos_mutex_init, but spins briefly before blocking if the target supports it.
+  // Used by os::Mutex when OS_MUTEX_ADAPTIVE is set or AdaptiveMutexPolicy is requested.
+  int rtos_mutex_init_adaptive(rt_mutex_t* m);
   int rtos_mutex_destroy(rt_mutex_t* m );
   int rtos_mutex_rec_init(rt_rec_mutex_t* m);
   int rtos_mutex_rec_destroy(rt_rec_mutex_t* m );
@@ -184,9 +184,58 @@ extern "C"
     typedef pthread_mutex_t rt_mutex_t;
     typedef pthread_mutex_t rt_rec_mutex_t;
 
+    /**
+     * Sets the priority inheritance protocol on \a attr if configured,
+     * such that a real-time thread waiting for a mutex is not held up by
+     * medium priority threads preempting the owner of the mutex.
+     */
+    static inline int rtos_mutexattr_set_protocol(pthread_mutexattr_t* attr)
+    {
+#if defined(OS_MUTEX_PRIO_INHERIT) && defined(_POSIX_THREAD_PRIO_INHERIT) && (_POSIX_THREAD_PRIO_INHERIT > 0)
+        return pthread_mutexattr_setprotocol(attr, PTHREAD_PRIO_INHERIT);
+#else
+        return 0;
+#endif
+    }
+
+    /**
+     * Initializes a mutex which spins for a short while in user space
+     * before it blocks in the kernel. This avoids a futex sleep and
+     * wake-up for very short critical sections under contention.
+     * Priority inheritance is never used for these mutexes, since the
+     * kernel does not support spinning on a PI futex.
+     */
+    static inline int rtos_mutex_init_adaptive(rt_mutex_t* m)
+    {
+#ifdef PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP
+        pthread_mutexattr_t attr;
+        int ret = pthread_mutexattr_init(&attr);
+        if (ret != 0) return ret;
+
+        ret = pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ADAPTIVE_NP);
+        if (ret == 0)
+            ret = pthread_mutex_init(m, &attr);
+
+        pthread_mutexattr_destroy(&attr);
+        return ret;
+#else
+        return pthread_mutex_init(m, 0);
+#endif
+    }
+
     static inline int rtos_mutex_init(rt_mutex_t* m)
     {
-        return pthread_mutex_init(m, 0 );
+        pthread_mutexattr_t attr;
+        int ret = pthread_mutexattr_init(&attr);
+        if (ret != 0) return ret;
+
+        // a plain mutex is used if priority inheritance is not supported.
+        rtos_mutexattr_set_protocol(&attr);
+
+        ret = pthread_mutex_init(m, &attr);
+
+        pthread_mutexattr_destroy(&attr);
+        return ret;
     }
 
     static inline int rtos_mutex_destroy(rt_mutex_t* m )
@@ -201,8 +250,14 @@ extern "C"
         if (ret != 0) return ret;
 
         // make mutex recursive
-        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE_NP);
-        if (ret != 0) return ret;
+        ret = pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE_NP);
+        if (ret != 0) {
+            pthread_mutexattr_destroy(&attr);
+            return ret;
+        }
+
+        // priority inheritance is optional, see rtos_mutex_init().
+        rtos_mutexattr_set_protocol(&attr);
 
         ret = pthread_mutex_init(m, &attr);
 
@@ -164,6 +164,12 @@ int rtos_nanosleep(const TIME_SPEC *rqtp, TIME_SPEC *rmtp)
         return m->sem == 0 ? -1 : 0;
     }
 
+    int rtos_mutex_init_adaptive(rt_mutex_t* m)
+    {
+        // RTAI semaphores do not spin.
+        return rtos_mutex_init(m);
+    }
+
     int rtos_mutex_destroy(rt_mutex_t* m )
     {
         CHK_LXRT_CALL();
@@ -261,6 +261,12 @@ inline int rtos_nanosleep(const TIME_SPEC *rqtp, TIME_SPEC *rmtp)
         return m->sem == 0 ? -1 : 0;
     }
 
+    static inline int rtos_mutex_init_adaptive(rt_mutex_t* m)
+    {
+        // RTAI semaphores do not spin.
+        return rtos_mutex_init(m);
+    }
+
     static inline int rtos_mutex_destroy(rt_mutex_t* m )
     {
         CHK_LXRT_CALL();
@@ -404,6 +410,8 @@ int rtos_nanosleep(const TIME_SPEC *rqtp, TIME_SPEC *rmtp) ;
 
 int rtos_mutex_init(rt_mutex_t* m);
 
+int rtos_mutex_init_adaptive(rt_mutex_t* m);
+
 int rtos_mutex_destroy(rt_mutex_t* m );
 
 int rtos_mutex_rec_init(rt_mutex_t* m);
@@ -44,6 +44,7 @@
 #include <map>
 
 #include "MutexLock.hpp"
+#include "MemoryStatistics.hpp"
 #include "oro_malloc.h"
 
 namespace RTT { namespace os {
@@ -245,10 +246,16 @@ namespace RTT { namespace os {
 
     /**
      * A real-time malloc allocator which allocates
-     * every block with oro_rt_malloc() and deallocates with oro_rt_free().
+     * every block with oro_rt_malloc() and deallocates with oro_rt_free(),
+     * and accounts the memory to subsystem \a S if
+     * OS_RT_MALLOC_SUBSYSTEM_STATS is set, see getSubsystemMemoryUsage().
      * This relies on the TLSF implementation.
+     *
+     * @param T the type to allocate memory for
+     * @param S the subsystem the memory is accounted to.
+     * @see rt_allocator for memory which is not attributed to a subsystem.
      */
-    template <class T> class rt_allocator
+    template <class T, MemorySubsystem S> class rt_subsystem_allocator
     {
     public:
         typedef T                 value_type;
@@ -270,12 +277,18 @@ namespace RTT { namespace os {
     public:
         pointer allocate(size_type n, const_pointer = 0) {
             void* p = oro_rt_malloc(n * sizeof(T));
+#if defined(OS_RT_MALLOC) && defined(OS_RT_MALLOC_SUBSYSTEM_STATS)
+            memoryAllocated(S, n * sizeof(T), p != 0);
+#endif
             if (!p)
                 throw std::bad_alloc();
             return static_cast<pointer>(p);
         }
 
-        void deallocate(pointer p, size_type) {
+        void deallocate(pointer p, size_type n) {
+#if defined(OS_RT_MALLOC) && defined(OS_RT_MALLOC_SUBSYSTEM_STATS)
+            memoryFreed(S, n * sizeof(T));
+#endif
             oro_rt_free(p);
         }
 
@@ -289,9 +302,57 @@ namespace RTT { namespace os {
 
         void destroy(pointer p) { p->~value_type(); }
 
+    public:
+        rt_subsystem_allocator() {}
+        rt_subsystem_allocator(const rt_subsystem_allocator&) {}
+        ~rt_subsystem_allocator() {}
+        template <class U>
+        rt_subsystem_allocator(const rt_subsystem_allocator<U, S>&) {}
+        void operator=(const rt_subsystem_allocator&) {}
+
+        template <class U>
+        struct rebind { typedef rt_subsystem_allocator<U, S> other; };
+    private:
+    };
+
+    template <class T, MemorySubsystem S>
+    inline bool operator==(const rt_subsystem_allocator<T, S>&,
+                           const rt_subsystem_allocator<T, S>&) {
+        return true;
+    }
+
+    template <class T, MemorySubsystem S>
+    inline bool operator!=(const rt_subsystem_allocator<T, S>&,
+                           const rt_subsystem_allocator<T, S>&) {
+        return false;
+    }
+
+    template<MemorySubsystem S> class rt_subsystem_allocator<void, S>
+    {
+    public:
+        typedef void        value_type;
+        typedef void*       pointer;
+        typedef const void* const_pointer;
+
+        template <class U>
+        struct rebind { typedef rt_subsystem_allocator<U, S> other; };
+    };
+
+    /**
+     * A real-time malloc allocator which allocates
+     * every block with oro_rt_malloc() and deallocates with oro_rt_free().
+     * This relies on the TLSF implementation. The memory is accounted
+     * to MemoryOther.
+     *
+     * @param T the type to allocate memory for
+     */
+    template <class T> class rt_allocator
+        : public rt_subsystem_allocator<T, MemoryOther>
+    {
     public:
         rt_allocator() {}
-        rt_allocator(const rt_allocator&) {}
+        rt_allocator(const rt_allocator&)
+            : rt_subsystem_allocator<T, MemoryOther>() {}
         ~rt_allocator() {}
         template <class U>
         rt_allocator(const rt_allocator<U>&) {}
@@ -299,7 +360,6 @@ namespace RTT { namespace os {
 
         template <class U>
         struct rebind { typedef rt_allocator<U> other; };
-    private:
     };
 
     template <class T>
@@ -76,6 +76,10 @@
 #define	USE_SBRK 	(0)
 #endif
 
+#ifndef TLSF_ARENAS
+#define	TLSF_ARENAS 	(0)
+#endif
+
 
 #if TLSF_USE_LOCKS
 #include "target.h"
@@ -89,16 +93,21 @@
 #if TLSF_STATISTIC
 #define	TLSF_ADD_SIZE(tlsf, b) do {									\
 		tlsf->used_size += (b->size & BLOCK_SIZE) + BHDR_OVERHEAD;	\
+		++tlsf->used_blocks;										\
 		if (tlsf->used_size > tlsf->max_size) 						\
 			tlsf->max_size = tlsf->used_size;						\
 		} while(0)
 
 #define	TLSF_REMOVE_SIZE(tlsf, b) do {								\
 		tlsf->used_size -= (b->size & BLOCK_SIZE) + BHDR_OVERHEAD;	\
+		--tlsf->used_blocks;										\
 	} while(0)
+
+#define	TLSF_ADD_FAILURE(tlsf)	     do { ++tlsf->failed_count; } while(0)
 #else
 #define	TLSF_ADD_SIZE(tlsf, b)	     do{}while(0)
 #define	TLSF_REMOVE_SIZE(tlsf, b)    do{}while(0)
+#define	TLSF_ADD_FAILURE(tlsf)	     do{}while(0)
 #endif
 
 #if USE_MMAP || USE_SBRK
@@ -115,6 +124,11 @@
 #endif
 #endif
 
+#if TLSF_ARENAS
+#include <pthread.h>
+#include "../oro_arch.h"
+#endif
+
 #define ORO_MEMORY_POOL
 #include "tlsf.h"
 
@@ -183,6 +197,19 @@
 
 #define DEFAULT_AREA_SIZE (1024*10)
 
+#if TLSF_ARENAS
+/* The number of threads which can have an arena at the same time */
+#ifndef TLSF_MAX_ARENAS
+#define TLSF_MAX_ARENAS (64)
+#endif
+/* The initial size of an arena, taken from the default memory pool */
+#ifndef TLSF_ARENA_SIZE
+#define TLSF_ARENA_SIZE (1024*64)
+#endif
+/* Every block of tlsf_malloc() starts with the arena it belongs to */
+#define ARENA_HDR (BLOCK_ALIGN)
+#endif
+
 #if USE_MMAP
 #define TLSF_PAGE_SIZE (getpagesize())
 #endif
@@ -231,6 +258,9 @@ typedef struct TLSF_struct {
      * do not know the sizes when freeing/reallocing memory. */
     size_t used_size;
     size_t max_size;
+    /* The number of allocated blocks and of failed allocations */
+    size_t used_blocks;
+    size_t failed_count;
 #endif
 
     /* A linked list holding all the existing areas */
@@ -246,6 +276,24 @@ typedef struct TLSF_struct {
     bhdr_t *matrix[REAL_FLI][MAX_SLI];
 } tlsf_t;
 
+#if TLSF_ARENAS
+/* A per-thread memory pool. Only the owner allocates from and frees
+ * to the pool, so it needs no lock. Other threads push the blocks they
+ * free on the returned list, which the owner empties when it allocates. */
+
+typedef struct arena_struct {
+    /* the TLSF pool of this arena, taken from the default pool */
+    void *pool;
+    /* lock-free list of blocks freed by other threads */
+    void *volatile returned;
+    /* 1 while a thread allocates from this arena */
+    volatile int owned;
+    pthread_t owner;
+    /* the default pool generation this arena's pool belongs to */
+    unsigned int generation;
+} arena_t;
+#endif
+
 
 /******************************************************************/
 /**************     Helping functions    **************************/
@@ -473,6 +521,130 @@ static __inline__ bhdr_t *process_area(void *area, size_t size)
 
 static char *mp = NULL;         /* Default memory pool. */
 
+#if TLSF_ARENAS
+static arena_t arenas[TLSF_MAX_ARENAS];
+/* Incremented when the default pool is destroyed, which also destroys all arenas */
+static volatile unsigned int mp_generation = 1;
+static pthread_key_t arena_key;
+static pthread_once_t arena_key_once = PTHREAD_ONCE_INIT;
+static volatile int arena_key_ready = 0;
+
+static void arena_release(void *arg);
+
+static void arena_create_key(void)
+{
+    if (pthread_key_create(&arena_key, arena_release) == 0)
+        arena_key_ready = 1;
+}
+
+/* Returns the arena of the calling thread, or NULL if it has none. */
+static __inline__ arena_t *arena_self(void)
+{
+    arena_t *a;
+
+    if (!arena_key_ready)
+        return NULL;
+    a = (arena_t *) pthread_getspecific(arena_key);
+    if (a && a->generation == mp_generation && pthread_equal(a->owner, pthread_self()))
+        return a;
+    return NULL;
+}
+
+/* Frees all blocks other threads returned to arena a. Only called by the
+ * thread which owns or has claimed the arena. */
+static __inline__ void arena_drain(arena_t *a)
+{
+    void *b, *next;
+
+    /* Taking the whole list at once avoids the ABA problem. */
+    do {
+        b = a->returned;
+    } while (b && oro_cmpxchg(&a->returned, b, (void *) 0) != b);
+
+    while (b) {
+        next = *(void **) b;
+        free_ex(b, a->pool);
+        b = next;
+    }
+}
+
+/* Gives up a claim on arena a. Blocks returned while the claim was
+ * held are freed first, and again when more arrive before the arena is
+ * unclaimed, such that an arena without owner never keeps blocks. */
+static void arena_unclaim(arena_t *a)
+{
+    do {
+        arena_drain(a);
+        oro_cmpxchg(&a->owned, 1, 0);
+    } while (a->returned && oro_cmpxchg(&a->owned, 0, 1) == 0);
+}
+
+/* Hands block b back to arena a, from any thread but its owner. */
+static __inline__ void arena_return(arena_t *a, void *b)
+{
+    void *head;
+
+    do {
+        head = a->returned;
+        *(void **) b = head;
+    } while (oro_cmpxchg(&a->returned, head, b) != head);
+
+    /* the owner exited: free the block on its behalf. */
+    if (!a->owned && a->generation == mp_generation && oro_cmpxchg(&a->owned, 0, 1) == 0)
+        arena_unclaim(a);
+}
+
+/* Claims an unused arena for the calling thread. An arena left by a
+ * thread which exited is reused with its pool, otherwise a new pool is
+ * taken from the default pool. Returns NULL if none is available. */
+static arena_t *arena_acquire(void)
+{
+    unsigned int i;
+    arena_t *a;
+    void *area;
+
+    pthread_once(&arena_key_once, arena_create_key);
+    if (!arena_key_ready || !mp)
+        return NULL;
+
+    for (i = 0; i != TLSF_MAX_ARENAS; ++i) {
+        a = &arenas[i];
+        if (a->owned || oro_cmpxchg(&a->owned, 0, 1) != 0)
+            continue;
+
+        if (!a->pool || a->generation != mp_generation) {
+            TLSF_ACQUIRE_LOCK(&((tlsf_t *)mp)->lock);
+            area = malloc_ex(TLSF_ARENA_SIZE, mp);
+            TLSF_RELEASE_LOCK(&((tlsf_t *)mp)->lock);
+            if (!area) {
+                a->owned = 0;
+                return NULL;
+            }
+            /* the area may still hold the signature of an earlier pool. */
+            memset(area, 0, sizeof(tlsf_t));
+            init_memory_pool(TLSF_ARENA_SIZE, area);
+            a->pool = area;
+            a->returned = NULL;
+            a->generation = mp_generation;
+        }
+        a->owner = pthread_self();
+        pthread_setspecific(arena_key, a);
+        return a;
+    }
+    return NULL;
+}
+
+/* Called when a thread with an arena exits, such that another thread can adopt it. */
+static void arena_release(void *arg)
+{
+    arena_t *a = (arena_t *) arg;
+
+    if (a->generation != mp_generation || !pthread_equal(a->owner, pthread_self()))
+        return;
+    arena_unclaim(a);
+}
+#endif
+
 /******************************************************************/
 size_t init_memory_pool(size_t mem_pool_size, void *mem_pool)
 {
@@ -515,6 +687,7 @@ size_t init_memory_pool(size_t mem_pool_size, void *mem_pool)
 #if TLSF_STATISTIC
     tlsf->used_size = mem_pool_size - (b->size & BLOCK_SIZE);
     tlsf->max_size = tlsf->used_size;
+    tlsf->used_blocks = 0;
 #endif
 
     return (b->size & BLOCK_SIZE);
@@ -527,6 +700,9 @@ size_t add_new_area(void *area, size_t area_size, void *mem_pool)
     tlsf_t *tlsf = (tlsf_t *) mem_pool;
     area_info_t *ptr, *ptr_prev, *ai;
     bhdr_t *ib0, *b0, *lb0, *ib1, *b1, *lb1, *next_b;
+#if TLSF_STATISTIC
+    size_t used_size = tlsf->used_size, used_blocks = tlsf->used_blocks;
+#endif
 
     memset(area, 0, area_size);
     ptr = tlsf->area_head;
@@ -595,6 +771,13 @@ size_t add_new_area(void *area, size_t area_size, void *mem_pool)
     ai->end = lb0;
     tlsf->area_head = ai;
     free_ex(b0->ptr.buffer, mem_pool);
+#if TLSF_STATISTIC
+    /* The new area was never allocated, only its headers are in use. */
+    tlsf->used_size = used_size + area_size - (b0->size & BLOCK_SIZE);
+    tlsf->used_blocks = used_blocks;
+    if (tlsf->used_size > tlsf->max_size)
+        tlsf->max_size = tlsf->used_size;
+#endif
     return (b0->size & BLOCK_SIZE);
 }
 
@@ -645,12 +828,63 @@ size_t get_max_size_mp()
 #endif
 }
 
+/******************************************************************/
+size_t get_used_blocks(void *mem_pool)
+{
+/******************************************************************/
+#if TLSF_STATISTIC
+    return ((tlsf_t *) mem_pool)->used_blocks;
+#else
+    return 0;
+#endif
+}
+
+/******************************************************************/
+// use default memory pool
+size_t get_used_blocks_mp()
+{
+/******************************************************************/
+#if TLSF_STATISTIC
+    return (mp ? ((tlsf_t *) mp)->used_blocks : 0);
+#else
+    return 0;
+#endif
+}
+
+/******************************************************************/
+size_t get_failed_count(void *mem_pool)
+{
+/******************************************************************/
+#if TLSF_STATISTIC
+    return ((tlsf_t *) mem_pool)->failed_count;
+#else
+    return 0;
+#endif
+}
+
+/******************************************************************/
+// use default memory pool
+size_t get_failed_count_mp()
+{
+/******************************************************************/
+#if TLSF_STATISTIC
+    return (mp ? ((tlsf_t *) mp)->failed_count : 0);
+#else
+    return 0;
+#endif
+}
+
 /******************************************************************/
 void destroy_memory_pool(void *mem_pool)
 {
 /******************************************************************/
     if((void*)mp == (void*)mem_pool){
         mp = 0;
+#if TLSF_ARENAS
+        /* the arena pools were part of the default pool. */
+        memset(arenas, 0, sizeof(arenas));
+        ++mp_generation;
+#endif
     }
 
     tlsf_t *tlsf = (tlsf_t *) mem_pool;
@@ -660,6 +894,142 @@ void destroy_memory_pool(void *mem_pool)
 }
 
 
+#if TLSF_ARENAS
+
+/******************************************************************/
+void *tlsf_malloc(size_t size)
+{
+/******************************************************************/
+    void *ret = NULL;
+    arena_t *a;
+
+#if USE_MMAP || USE_SBRK
+    if (!mp) {
+        size_t area_size;
+        void *area;
+
+        area_size = sizeof(tlsf_t) + BHDR_OVERHEAD * 8; /* Just a safety constant */
+        area_size = (area_size > DEFAULT_AREA_SIZE) ? area_size : DEFAULT_AREA_SIZE;
+        area = get_new_area(&area_size);
+        if (area == ((void *) ~0))
+            return NULL;        /* Not enough system memory */
+        init_memory_pool(area_size, area);
+    }
+#endif
+
+    a = arena_self();
+    if (!a)
+        a = arena_acquire();
+    if (a) {
+        arena_drain(a);
+        ret = malloc_ex(size + ARENA_HDR, a->pool);
+    }
+
+    if (!ret) {
+        /* no arena or arena exhausted: use the default pool */
+        a = NULL;
+        TLSF_ACQUIRE_LOCK(&((tlsf_t *)mp)->lock);
+
+        ret = malloc_ex(size + ARENA_HDR, mp);
+
+        TLSF_RELEASE_LOCK(&((tlsf_t *)mp)->lock);
+        if (!ret)
+            return NULL;
+    }
+
+    *(arena_t **) ret = a;
+    return (char *) ret + ARENA_HDR;
+}
+
+/******************************************************************/
+void tlsf_free(void *ptr)
+{
+/******************************************************************/
+    bhdr_t *b;
+    arena_t *a;
+
+    if (!ptr)
+        return;
+
+    ptr = (char *) ptr - ARENA_HDR;
+    b = (bhdr_t *) ((char *) ptr - BHDR_OVERHEAD);
+    /* the arena pointer is overwritten when a block is freed. */
+    if( (b->size & BLOCK_STATE) != USED_BLOCK )
+        corrupt( "tlsf_free(): Freeing unused block\n" );
+
+    a = *(arena_t **) ptr;
+    if (!a) {
+        TLSF_ACQUIRE_LOCK(&((tlsf_t *)mp)->lock);
+
+        free_ex(ptr, mp);
+
+        TLSF_RELEASE_LOCK(&((tlsf_t *)mp)->lock);
+    } else if (a == arena_self()) {
+        free_ex(ptr, a->pool);
+    } else {
+        arena_return(a, ptr);
+    }
+}
+
+/******************************************************************/
+void *tlsf_realloc(void *ptr, size_t size)
+{
+/******************************************************************/
+    void *ret = NULL;
+    arena_t *a;
+    bhdr_t *b;
+    size_t cpsize;
+
+    if (!ptr)
+        return tlsf_malloc(size);
+    if (!size) {
+        tlsf_free(ptr);
+        return NULL;
+    }
+
+    ptr = (char *) ptr - ARENA_HDR;
+    a = *(arena_t **) ptr;
+    if (!a) {
+        TLSF_ACQUIRE_LOCK(&((tlsf_t *)mp)->lock);
+
+        ret = realloc_ex(ptr, size + ARENA_HDR, mp);
+
+        TLSF_RELEASE_LOCK(&((tlsf_t *)mp)->lock);
+    } else if (a == arena_self()) {
+        ret = realloc_ex(ptr, size + ARENA_HDR, a->pool);
+    }
+    if (ret)
+        return (char *) ret + ARENA_HDR;
+
+    /* the block belongs to another thread or its pool is exhausted. */
+    b = (bhdr_t *) ((char *) ptr - BHDR_OVERHEAD);
+    cpsize = (b->size & BLOCK_SIZE) - ARENA_HDR;
+    ret = tlsf_malloc(size);
+    if (ret) {
+        memcpy(ret, (char *) ptr + ARENA_HDR, cpsize < size ? cpsize : size);
+        tlsf_free((char *) ptr + ARENA_HDR);
+    }
+    return ret;
+}
+
+/******************************************************************/
+void *tlsf_calloc(size_t nelem, size_t elem_size)
+{
+/******************************************************************/
+    void *ret;
+
+    if (nelem <= 0 || elem_size <= 0)
+        return NULL;
+
+    if (!(ret = tlsf_malloc(nelem * elem_size)))
+        return NULL;
+    memset(ret, 0, nelem * elem_size);
+
+    return ret;
+}
+
+#else
+
 /******************************************************************/
 void *tlsf_malloc(size_t size)
 {
@@ -738,6 +1108,42 @@ void *tlsf_calloc(size_t nelem, size_t elem_size)
     return ret;
 }
 
+#endif
+
+/******************************************************************/
+unsigned int get_arena_count()
+{
+/******************************************************************/
+#if TLSF_ARENAS
+    return TLSF_MAX_ARENAS;
+#else
+    return 0;
+#endif
+}
+
+/******************************************************************/
+void *get_arena_pool(unsigned int arena)
+{
+/******************************************************************/
+#if TLSF_ARENAS
+    if (arena < TLSF_MAX_ARENAS && arenas[arena].generation == mp_generation)
+        return arenas[arena].pool;
+#endif
+    return NULL;
+}
+
+/******************************************************************/
+void *get_arena_pool_self()
+{
+/******************************************************************/
+#if TLSF_ARENAS
+    arena_t *a = arena_self();
+    if (a)
+        return a->pool;
+#endif
+    return mp;
+}
+
 /******************************************************************/
 void *malloc_ex(size_t size, void *mem_pool)
 {
@@ -772,8 +1178,10 @@ void *malloc_ex(size_t size, void *mem_pool)
         b = FIND_SUITABLE_BLOCK(tlsf, &fl, &sl);
     }
 #endif
-    if (!b)
+    if (!b) {
+        TLSF_ADD_FAILURE(tlsf);
         return NULL;            /* Not found */
+    }
 
     EXTRACT_BLOCK_HDR(b, tlsf, fl, sl);
 
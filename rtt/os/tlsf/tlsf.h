@@ -38,6 +38,15 @@ extern size_t get_used_size(void *);
 extern size_t get_used_size_mp();
 extern size_t get_max_size(void *);
 extern size_t get_max_size_mp();
+extern size_t get_used_blocks(void *);
+extern size_t get_used_blocks_mp();
+extern size_t get_failed_count(void *);
+extern size_t get_failed_count_mp();
+/* Per-thread pools, see OS_RT_MALLOC_ARENAS. Use get_used_size() and
+ * get_max_size() on the returned pools for their statistics. */
+extern unsigned int get_arena_count();
+extern void *get_arena_pool(unsigned int);
+extern void *get_arena_pool_self();
 extern void destroy_memory_pool(void *);
 extern size_t add_new_area(void *, size_t, void *);
 extern void *malloc_ex(size_t, void *);
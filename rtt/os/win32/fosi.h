@@ -237,6 +237,12 @@ extern "C"
         return 0;
     }
 
+    static inline int rtos_mutex_init_adaptive(rt_mutex_t* m)
+    {
+        // a critical section spins before it waits on its event.
+        return InitializeCriticalSectionAndSpinCount(m, 4000) ? 0 : -1;
+    }
+
     static inline int rtos_mutex_destroy(rt_mutex_t* m )
     {
 		DeleteCriticalSection(m);
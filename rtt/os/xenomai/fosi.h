@@ -235,6 +235,12 @@ static inline int rtos_nanosleep(const TIME_SPEC *rqtp, TIME_SPEC *rmtp)
         return rt_mutex_create(m, 0);
     }
 
+    static inline int rtos_mutex_init_adaptive(rt_mutex_t* m)
+    {
+        // Xenomai mutexes do not spin.
+        return rtos_mutex_init(m);
+    }
+
     static inline int rtos_mutex_destroy(rt_mutex_t* m )
     {
         CHK_XENO_CALL();
@@ -42,6 +42,6 @@ namespace std
     /*
      * Explicit template instantiation
      */
-    template class basic_string<char, char_traits<char>, RTT::os::rt_allocator<char> >;
-    template class basic_ostringstream<char, char_traits<char>, RTT::os::rt_allocator<char> >;
+    template class basic_string<char, char_traits<char>, RTT::rt_string_allocator >;
+    template class basic_ostringstream<char, char_traits<char>, RTT::rt_string_allocator >;
 }
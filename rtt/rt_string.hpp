@@ -46,11 +46,19 @@
 
 namespace RTT
 {
+#ifdef OS_RT_MALLOC_SUBSYSTEM_STATS
+    /// The allocator of rt_string, which accounts its memory to MemoryStrings
+    typedef RTT::os::rt_subsystem_allocator<char, RTT::os::MemoryStrings> rt_string_allocator;
+#else
+    /// The allocator of rt_string
+    typedef RTT::os::rt_allocator<char> rt_string_allocator;
+#endif
+
     /// Real-time allocatable, dynamically-sized string
-    typedef std::basic_string<char, std::char_traits<char>, RTT::os::rt_allocator<char> > rt_string;
+    typedef std::basic_string<char, std::char_traits<char>, RTT::rt_string_allocator > rt_string;
 
     /// Real-time allocatable, dynamically-size output string stream
-    typedef std::basic_ostringstream<char, std::char_traits<char>, RTT::os::rt_allocator<char> > rt_ostringstream;
+    typedef std::basic_ostringstream<char, std::char_traits<char>, RTT::rt_string_allocator > rt_ostringstream;
 
     //! convert from real-time string to std::string
     inline std::string makeString(const RTT::rt_string& str)
@@ -71,8 +79,8 @@ namespace std
     /**
      * Extern template declaration
      */
-    RTT_EXT_IMPL template class basic_string<char, char_traits<char>, RTT::os::rt_allocator<char> >;
-    RTT_EXT_IMPL template class basic_ostringstream<char, char_traits<char>, RTT::os::rt_allocator<char> >;
+    RTT_EXT_IMPL template class basic_string<char, char_traits<char>, RTT::rt_string_allocator >;
+    RTT_EXT_IMPL template class basic_ostringstream<char, char_traits<char>, RTT::rt_string_allocator >;
 }
 
 #endif
@@ -56,6 +56,9 @@ RTT::corba::CConnPolicy toCORBA(RTT::ConnPolicy const& policy)
     corba_policy.data_size   = policy.data_size;
     corba_policy.transport   = policy.transport;
     corba_policy.name_id     = CORBA::string_dup( policy.name_id.c_str() );
+    corba_policy.dispatcher_scheduler    = policy.dispatcher_scheduler;
+    corba_policy.dispatcher_priority     = policy.dispatcher_priority;
+    corba_policy.dispatcher_cpu_affinity = policy.dispatcher_cpu_affinity;
     return corba_policy;
 }
 
@@ -70,5 +73,8 @@ RTT::ConnPolicy toRTT(RTT::corba::CConnPolicy const& corba_policy)
     policy.data_size   = corba_policy.data_size;
     policy.transport   = corba_policy.transport;
     policy.name_id     = corba_policy.name_id;
+    policy.dispatcher_scheduler    = corba_policy.dispatcher_scheduler;
+    policy.dispatcher_priority     = corba_policy.dispatcher_priority;
+    policy.dispatcher_cpu_affinity = corba_policy.dispatcher_cpu_affinity;
     return policy;
 }
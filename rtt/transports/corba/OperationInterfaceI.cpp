@@ -76,6 +76,7 @@
 #include "../../Logger.hpp"
 #include "../../internal/GlobalEngine.hpp"
 #include "../../plugin/PluginLoader.hpp"
+#include "../../os/MutexLock.hpp"
 
 using namespace RTT;
 using namespace RTT::detail;
@@ -217,7 +218,8 @@ void RTT_corba_CSendHandle_i::dispose (
 RTT_corba_COperationInterface_i::RTT_corba_COperationInterface_i (OperationInterface* gmf, PortableServer::POA_ptr the_poa)
     : mfact(gmf), mpoa( PortableServer::POA::_duplicate(the_poa)),
       loadPluginOperation("loadPlugin", &RTT_corba_COperationInterface_i::loadPlugin, this),
-      loadPluginOperationPart(&loadPluginOperation)
+      loadPluginOperationPart(&loadPluginOperation),
+      mcalls_revision(gmf->getRevision())
 {
     loadPluginOperation.doc("Loads a RTT plugin.").arg("plugin_path", "The path to the shared library containing the plugin.");
 }
@@ -360,6 +362,36 @@ void RTT_corba_COperationInterface_i::checkOperation (
 {
     OperationInterfacePart* mofp = findOperation(operation);
 
+    // try the operation as resolved by a previous call. Any mismatch
+    // falls through to the path below, which reports the proper error.
+    boost::shared_ptr<CachedCall> cc = getCachedCall(operation, mofp);
+    if ( cc ) {
+        os::MutexTryLock trylock(cc->lock);
+        const vector<DataSourceBase::shared_ptr>& bound = cc->caller.getArguments();
+        if ( trylock.isSuccessful() && args.length() == bound.size() ) {
+            bool converted = true;
+            for (size_t i =0; i != args.length() && converted; ++i)
+                converted = cc->args[i]->updateFromAny( &args[i], bound[i] );
+            if ( converted ) {
+                try {
+                    DataSourceBase::shared_ptr ds = cc->caller.getCallDataSource();
+                    CORBA::Any* retany;
+                    if ( !cc->ret ) {
+                        ds->evaluate();
+                        retany = new CORBA::Any();
+                    } else {
+                        retany = cc->ret->createAny( ds ); // call evaluate internally
+                    }
+                    for (size_t i =0; i != args.length(); ++i)
+                        cc->args[i]->updateAny(bound[i], args[i]);
+                    return retany;
+                } catch (std::runtime_error& e){
+                    throw ::RTT::corba::CCallError(e.what());
+                }
+            }
+        }
+    }
+
     // convert Corba args to C++ args.
     try {
         OperationCallerC orig(mofp, operation, internal::GlobalEngine::Instance());
@@ -460,6 +492,48 @@ RTT::OperationInterfacePart *RTT_corba_COperationInterface_i::findOperation( con
     return mofp;
 }
 
+boost::shared_ptr<RTT_corba_COperationInterface_i::CachedCall> RTT_corba_COperationInterface_i::getCachedCall( const char* operation, OperationInterfacePart* part )
+{
+    os::MutexLock lock(mcalls_lock);
+    // any change of the interface may have deleted the parts we resolved.
+    if ( mcalls_revision != mfact->getRevision() ) {
+        mcalls.clear();
+        mcalls_revision = mfact->getRevision();
+    }
+    CallCache::iterator it = mcalls.find(operation);
+    if ( it != mcalls.end() )
+        return it->second->caller.ready() ? it->second : boost::shared_ptr<CachedCall>();
+
+    boost::shared_ptr<CachedCall> cc( new CachedCall() );
+    cc->ret = 0;
+    try {
+        cc->caller = OperationCallerC(part, operation, internal::GlobalEngine::Instance());
+        cc->caller.bindArguments();
+    } catch (...) {
+        // let the uncached path report the error.
+        return boost::shared_ptr<CachedCall>();
+    }
+    if ( !cc->caller.ready() )
+        return boost::shared_ptr<CachedCall>();
+    for (unsigned int i = 1; i <= part->arity(); ++i) {
+        const TypeInfo* ti = part->getArgumentType( i );
+        CorbaTypeTransporter* ctt = ti ? dynamic_cast<CorbaTypeTransporter*> ( ti->getProtocol(ORO_CORBA_PROTOCOL_ID) ) : 0;
+        if ( !ctt ) {
+            // remember that this operation can not be cached.
+            cc->caller = OperationCallerC();
+            mcalls[operation] = cc;
+            return boost::shared_ptr<CachedCall>();
+        }
+        cc->args.push_back( ctt );
+    }
+    const TypeInfo* ti = cc->caller.getCallDataSource()->getTypeInfo();
+    cc->ret = dynamic_cast<CorbaTypeTransporter*> ( ti->getProtocol(ORO_CORBA_PROTOCOL_ID) );
+    if ( !cc->ret )
+        log(Warning) << "Could not return results of call to " << operation << ": unknown return type by CORBA transport."<<endlog();
+    mcalls[operation] = cc;
+    return cc;
+}
+
 bool RTT_corba_COperationInterface_i::loadPlugin(const string &pluginPath) {
     return RTT::plugin::PluginLoader::Instance()->loadPlugin(pluginPath, "");
 }
@@ -78,6 +78,11 @@
 #include "../../OperationInterface.hpp"
 #include "../../internal/SendHandleC.hpp"
 #include "../../internal/OperationInterfacePartFused.hpp"
+#include "../../internal/OperationCallerC.hpp"
+#include "../../os/Mutex.hpp"
+#include "rtt-corba-fwd.hpp"
+#include <boost/shared_ptr.hpp>
+#include <map>
 
 #if !defined (ACE_LACKS_PRAGMA_ONCE)
 #pragma once
@@ -188,6 +193,32 @@ class  RTT_corba_COperationInterface_i
     private:
         RTT::OperationInterfacePart *findOperation ( const char *operation );
         bool loadPlugin ( const std::string& pluginPath );
+
+        /**
+         * An operation which was resolved once by callOperation(), with
+         * value storage for its arguments. Repeated calls only convert the
+         * arguments into this storage. The lock serializes callers which
+         * use the same entry; concurrent callers take the uncached path.
+         */
+        struct CachedCall {
+            RTT::internal::OperationCallerC caller;
+            std::vector<RTT::corba::CorbaTypeTransporter*> args;
+            RTT::corba::CorbaTypeTransporter* ret;
+            RTT::os::Mutex lock;
+        };
+        typedef std::map<std::string, boost::shared_ptr<CachedCall> > CallCache;
+        CallCache mcalls;
+        unsigned int mcalls_revision;
+        RTT::os::Mutex mcalls_lock;
+
+        /**
+         * Returns the cached call of \a operation, resolved to \a part,
+         * or creates it. Returns null if the operation's arguments or
+         * return value can not be converted by the CORBA transport.
+         * The cache is emptied whenever the revision of the operation
+         * interface changes, since its parts may have been deleted.
+         */
+        boost::shared_ptr<CachedCall> getCachedCall( const char* operation, RTT::OperationInterfacePart* part );
 };
 
 
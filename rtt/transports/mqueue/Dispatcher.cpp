@@ -40,13 +40,22 @@
 
 namespace RTT {
     namespace mqueue {
-        Dispatcher* Dispatcher::DispatchI = 0;
+        Dispatcher::DispatcherMap Dispatcher::Dispatchers;
+        os::Mutex Dispatcher::DispatchersLock;
 
         void intrusive_ptr_add_ref(const RTT::mqueue::Dispatcher* p ) {
             p->refcount.inc();
         }
         void intrusive_ptr_release(const RTT::mqueue::Dispatcher* p ) {
-            if ( p->refcount.dec_and_test() ) delete p;
+            // Instance() may not hand out a dispatcher which is being deleted,
+            // so the last reference is dropped under its lock.
+            {
+                os::MutexLock lock(Dispatcher::DispatchersLock);
+                if ( !p->refcount.dec_and_test() )
+                    return;
+                Dispatcher::Dispatchers.erase(p->msettings);
+            }
+            delete p;
         }
     }
 }
@@ -42,7 +42,18 @@
 #include "../../base/ChannelElementBase.hpp"
 #include "../../Logger.hpp"
 #include <map>
+#include <boost/lexical_cast.hpp>
+#ifdef OROPKG_OS_GNULINUX
+// only the message queues of the Linux kernel can be watched with epoll,
+// the ones of the Xenomai POSIX skin only support select().
+#define ORO_MQUEUE_EPOLL
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#else
 #include <sys/select.h>
+#endif
+#include <unistd.h>
+#include <stdint.h>
 #include <mqueue.h>
 
 namespace RTT { namespace mqueue { class Dispatcher; } }
@@ -56,50 +67,113 @@ namespace RTT {
          * This object waits on a set of open message queue
          * file descriptors and signals the channel that has
          * received new data.
-         * Reasonably, there should be one dispatcher for each
-         * peer component sending us data.
+         * There is one dispatcher for each combination of scheduler,
+         * priority and cpu affinity requested in the ConnPolicy of
+         * the connections, such that a high priority connection is
+         * not delayed by the others.
+         *
+         * On GNU/Linux, the queues are watched with epoll, so adding
+         * and removing a queue does not interrupt the dispatcher and a
+         * wake-up only visits the queues which became readable. The
+         * other targets select() on the queues, which picks up changes
+         * to the set of queues within 50ms.
          */
         class Dispatcher : public Activity
         {
             friend void intrusive_ptr_add_ref(const RTT::mqueue::Dispatcher* p );
             friend void intrusive_ptr_release(const RTT::mqueue::Dispatcher* p );
             mutable os::AtomicInt refcount;
-            static Dispatcher* DispatchI;
+
+            /* The key of a dispatcher: scheduler, priority and cpu affinity. */
+            struct Settings {
+                int scheduler, priority;
+                unsigned int cpu_affinity;
+                bool operator<(const Settings& o) const {
+                    if (scheduler != o.scheduler) return scheduler < o.scheduler;
+                    if (priority != o.priority) return priority < o.priority;
+                    return cpu_affinity < o.cpu_affinity;
+                }
+            };
+            typedef std::map<Settings,Dispatcher*> DispatcherMap;
+            static DispatcherMap Dispatchers;
+            static os::Mutex DispatchersLock;
+            Settings msettings;
 
             typedef std::map<mqd_t,base::ChannelElementBase*> MQMap;
             MQMap mqmap;
 
+#ifdef ORO_MQUEUE_EPOLL
+            int epfd;            /* The epoll instance watching all queues */
+
+            int wakefd;          /* An eventfd which wakes up loop() when we must stop */
+
+            enum { MaxEvents = 64 }; /* The number of queues serviced per epoll_wait() */
+#else
             fd_set socks;        /* Socket file descriptors we want to wake up for, using select() */
 
             int highsock;        /* Highest #'d file descriptor, needed for select() */
+#endif
 
             bool do_exit;
 
             os::Mutex maplock;
 
-            Dispatcher( const std::string& name)
-            : Activity(ORO_SCHED_RT, os::HighestPriority, 0.0, 0, name),
+#ifdef ORO_MQUEUE_EPOLL
+            Dispatcher( const std::string& name, const Settings& settings)
+            : Activity(settings.scheduler, settings.priority, 0.0, settings.cpu_affinity, 0, name),
+              msettings(settings),
+              epfd( epoll_create1(EPOLL_CLOEXEC) ), wakefd( eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC) ),
+              do_exit(false)
+              {
+                  struct epoll_event ev;
+                  ev.events = EPOLLIN;
+                  ev.data.fd = wakefd;
+                  if ( epfd < 0 || wakefd < 0 || epoll_ctl(epfd, EPOLL_CTL_ADD, wakefd, &ev) != 0 )
+                      log(Error) <<"Dispatcher failed to create its epoll instance: "<<strerror(errno)<<endlog();
+              }
+#else
+            Dispatcher( const std::string& name, const Settings& settings)
+            : Activity(settings.scheduler, settings.priority, 0.0, settings.cpu_affinity, 0, name),
+              msettings(settings),
               highsock(0), do_exit(false)
               {}
+#endif
 
             ~Dispatcher() {
                 Logger::In in("Dispatcher");
                 log(Info) << "Dispacher cleans up: no more work."<<endlog();
+                // intrusive_ptr_release() removed us from Dispatchers.
                 stop();
-                DispatchI = 0;
+#ifdef ORO_MQUEUE_EPOLL
+                close(wakefd);
+                close(epfd);
+#endif
             }
 
+#ifdef ORO_MQUEUE_EPOLL
+            void read_socks(struct epoll_event* events, int readsocks) {
+                /* Service the queues which are ready for reading. A queue
+                   may have been removed since epoll_wait() returned, so we
+                   look it up under the lock. */
+                os::MutexLock lock(maplock);
+                for (int i = 0; i != readsocks; ++i) {
+                    if ( events[i].data.fd == wakefd ) {
+                        uint64_t count;
+                        ssize_t ret = read(wakefd, &count, sizeof(count));
+                        (void)ret;
+                        continue;
+                    }
+                    MQMap::iterator it = mqmap.find( events[i].data.fd );
+                    if ( it != mqmap.end() ) {
+                        //log(Debug) << "New data on " << it->first <<endlog();
+                        it->second->signal();
+                    }
+                }
+            }
+#else
             void build_select_list() {
-
-                /* First put together fd_set for select(), which will
-                   consist of the sock veriable in case a new connection
-                   is coming in, plus all the sockets we have already
-                   accepted. */
-
-
                 /* FD_ZERO() clears out the fd_set called socks, so that
                     it doesn't contain any file descriptors. */
-
                 FD_ZERO(&socks);
                 highsock = 0;
 
@@ -114,9 +188,6 @@ namespace RTT {
             }
 
             void read_socks() {
-                /* OK, now socks will be set with whatever socket(s)
-                   are ready for reading.*/
-
                 /* Run through our sockets and check to see if anything
                     happened with them, if so 'service' them. */
                 os::MutexLock lock(maplock);
@@ -127,16 +198,32 @@ namespace RTT {
                     }
                 }
             }
+#endif
 
         public:
             typedef boost::intrusive_ptr<Dispatcher> shared_ptr;
 
-            static Dispatcher::shared_ptr Instance() {
-                if ( DispatchI == 0) {
-                    DispatchI = new Dispatcher("MQueueDispatch");
-                    DispatchI->start();
-                }
-                return DispatchI;
+            /**
+             * Returns the dispatcher running with the given settings,
+             * and creates and starts it if there is none yet.
+             * @param scheduler The scheduler of the dispatcher thread.
+             * @param priority The priority of the dispatcher thread.
+             * @param cpu_affinity The cpu affinity mask of the dispatcher
+             * thread, zero for any cpu.
+             */
+            static Dispatcher::shared_ptr Instance(int scheduler = ORO_SCHED_RT, int priority = os::HighestPriority, unsigned int cpu_affinity = 0) {
+                Settings settings;
+                settings.scheduler = scheduler;
+                settings.priority = priority;
+                settings.cpu_affinity = cpu_affinity;
+                os::MutexLock lock(DispatchersLock);
+                DispatcherMap::iterator it = Dispatchers.find(settings);
+                if ( it != Dispatchers.end() )
+                    return it->second;
+                Dispatcher* d = new Dispatcher( Dispatchers.empty() ? "MQueueDispatch" : "MQueueDispatch" + boost::lexical_cast<std::string>(Dispatchers.size()), settings);
+                Dispatchers[settings] = d;
+                d->start();
+                return d;
             }
 
             void addQueue( mqd_t mqdes, base::ChannelElementBase* chan ) {
@@ -148,8 +235,18 @@ namespace RTT {
                 log(Debug) <<"Dispatcher is monitoring mqdes "<< mqdes <<endlog();
                 os::MutexLock lock(maplock);
                 // we add a refcount per channel we monitor.
-                if (mqmap.count(mqdes) == 0)
+                if (mqmap.count(mqdes) == 0) {
+#ifdef ORO_MQUEUE_EPOLL
+                    struct epoll_event ev;
+                    ev.events = EPOLLIN;
+                    ev.data.fd = mqdes;
+                    if ( epoll_ctl(epfd, EPOLL_CTL_ADD, mqdes, &ev) != 0 ) {
+                        log(Error) <<"Dispatcher failed to monitor mqdes "<< mqdes <<": "<<strerror(errno)<<endlog();
+                        return;
+                    }
+#endif
                     refcount.inc();
+                }
                 mqmap[mqdes] = chan;
             }
 
@@ -158,6 +255,9 @@ namespace RTT {
                 log(Debug) <<"Dispatcher drops mqdes "<< mqdes <<endlog();
                 os::MutexLock lock(maplock);
                 if (mqmap.count(mqdes)) {
+#ifdef ORO_MQUEUE_EPOLL
+                    epoll_ctl(epfd, EPOLL_CTL_DEL, mqdes, 0);
+#endif
                     mqmap.erase( mqmap.find(mqdes) );
                     refcount.dec();
                 }
@@ -168,29 +268,51 @@ namespace RTT {
                 return true;
             }
 
+#ifdef ORO_MQUEUE_EPOLL
+            void loop() {
+                struct epoll_event events[MaxEvents];
+                int readsocks;       /* Number of queues ready for reading */
+                while (1) { /* epoll loop */
+                    /* We wait without timeout: breakLoop() wakes us up through wakefd. */
+                    readsocks = epoll_wait(epfd, events, MaxEvents, -1);
+
+                    if (readsocks < 0) {
+                        if (errno != EINTR)
+                        {
+                            log(Error) <<"Dispatcher failed to wait on message queues. Stopped thread. error: "<<strerror(errno)<<endlog();
+                            return;
+                        }
+                    }
+                    else if (readsocks == 0) {
+                        // nop
+                    } else // readsocks > 0
+                        read_socks(events, readsocks);
+
+                    if ( do_exit )
+                        return;
+                } /* while(1) */
+            }
+
+            bool breakLoop() {
+                do_exit = true;
+                uint64_t one = 1;
+                ssize_t ret = write(wakefd, &one, sizeof(one));
+                (void)ret;
+                return true;
+            }
+#else
             void loop() {
                 struct timeval timeout;  /* Timeout for select */
                 int readsocks;       /* Number of sockets ready for reading */
                 while (1) { /* select loop */
                     build_select_list();
+                    /* We check do_exit and changes to the queues every 50ms. */
                     timeout.tv_sec = 0;
                     timeout.tv_usec = 50000;
 
-                    /* The first argument to select is the highest file
-                        descriptor value plus 1.*/
-
                     readsocks = select(highsock+1, &socks, (fd_set *) 0,
                       (fd_set *) 0, &timeout);
 
-                    /* select() returns the number of sockets that had
-                        things going on with them -- i.e. they're readable. */
-
-                    /* Once select() returns, the original fd_set has been
-                        modified so it now reflects the state of why select()
-                        woke up. i.e. If file descriptor 4 was originally in
-                        the fd_set, and then it became readable, the fd_set
-                        contains file descriptor 4 in it. */
-
                     if (readsocks < 0) {
                         if (errno != EINTR)
                         {
@@ -212,7 +334,7 @@ namespace RTT {
                 do_exit = true;
                 return true;
             }
+#endif
         };
     }
 }
-
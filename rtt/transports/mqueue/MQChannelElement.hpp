@@ -70,10 +70,12 @@ namespace RTT
             /**
              * Create a channel element for remote data exchange.
              * @param transport The type specific object that will be used to marshal the data.
+             * @param fixed_layout True if \a transport always marshals a sample
+             * of T into the same number of bytes.
              */
             MQChannelElement(base::PortInterface* port, types::TypeMarshaller const& transport,
-                             const ConnPolicy& policy, bool is_sender)
-                : MQSendRecv(transport)
+                             const ConnPolicy& policy, bool is_sender, bool fixed_layout = false)
+                : MQSendRecv(transport, fixed_layout)
                 , read_sample(new internal::ValueDataSource<T>)
                 , write_sample(new internal::LateConstReferenceDataSource<T>)
 
@@ -97,6 +99,13 @@ namespace RTT
                 return false;
             }
 
+            bool mqDataSample()
+            {
+                typename base::ChannelElement<T>::shared_ptr output =
+                    this->getOutput();
+                return output && mqRead(read_sample) && output->data_sample(read_sample->rvalue());
+            }
+
             virtual bool data_sample(typename base::ChannelElement<T>::param_t sample)
             {
                 // send initial data sample to the other side using a plain write.
@@ -107,7 +116,7 @@ namespace RTT
                     write_sample->setPointer(&sample);
                     // update MQSendRecv buffer:
                     mqNewSample(write_sample);
-                    return mqWrite(write_sample);
+                    return mqWrite(write_sample, true);
                 }
                 return false;
             }
@@ -142,8 +151,15 @@ namespace RTT
                 } else {
                     typename base::ChannelElement<T>::shared_ptr output =
                         this->getOutput();
-                    if (output && mqRead(read_sample))
-                        return output->write(read_sample->rvalue());
+                    if (!output)
+                        return false;
+                    // read all queued samples, but not more than the queue
+                    // can hold, such that a writer which keeps on writing
+                    // does not starve the other queues of the dispatcher.
+                    bool written = false;
+                    for (int i = 0; i != mmax_batch && mqRead(read_sample); ++i)
+                        written = output->write(read_sample->rvalue()) || written;
+                    return written;
                 }
                 return false;
             }
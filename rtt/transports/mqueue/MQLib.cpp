@@ -43,34 +43,47 @@
 #include "../../types/TransportPlugin.hpp"
 #include "../../types/TypekitPlugin.hpp"
 #include <boost/serialization/vector.hpp>
+#include <boost/serialization/string.hpp>
 
 using namespace std;
 using namespace RTT::detail;
 
 namespace RTT {
     namespace mqueue {
+        /**
+         * Registers protocol \a P for the message queue, the shared
+         * memory and the fragmenting transport.
+         */
+        template<class P>
+        static bool addProtocols(TypeInfo* ti)
+        {
+            bool ok = ti->addProtocol(ORO_MQUEUE_PROTOCOL_ID, new P() );
+            ok = ti->addProtocol(ORO_MQUEUE_SHM_PROTOCOL_ID, new P() ) && ok;
+            return ti->addProtocol(ORO_MQUEUE_FRAGMENT_PROTOCOL_ID, new P() ) && ok;
+        }
+
         bool MQLibPlugin::registerTransport(std::string name, TypeInfo* ti)
         {
             if ( name == "int" )
-                return ti->addProtocol(ORO_MQUEUE_PROTOCOL_ID, new MQTemplateProtocol<int>() );
+                return addProtocols< MQTemplateProtocol<int> >(ti);
             if ( name == "double" )
-                return ti->addProtocol(ORO_MQUEUE_PROTOCOL_ID, new MQTemplateProtocol<double>() );
-            //if ( name == "string" )
-            //    return ti->addProtocol(ORO_MQUEUE_PROTOCOL_ID, new MQTemplateProtocol<std::string>() );
+                return addProtocols< MQTemplateProtocol<double> >(ti);
+            if ( name == "string" )
+                return addProtocols< MQSerializationProtocol<std::string> >(ti);
             if ( name == "float" )
-                return ti->addProtocol(ORO_MQUEUE_PROTOCOL_ID, new MQTemplateProtocol<float>() );
+                return addProtocols< MQTemplateProtocol<float> >(ti);
             if ( name == "uint" )
-                return ti->addProtocol(ORO_MQUEUE_PROTOCOL_ID, new MQTemplateProtocol<unsigned int>() );
+                return addProtocols< MQTemplateProtocol<unsigned int> >(ti);
             if ( name == "char" )
-                return ti->addProtocol(ORO_MQUEUE_PROTOCOL_ID, new MQTemplateProtocol<char>() );
+                return addProtocols< MQTemplateProtocol<char> >(ti);
             //if ( name == "long" )
             //    return ti->addProtocol(ORO_MQUEUE_PROTOCOL_ID, new MQTemplateProtocol<long>() );
             //if ( name == "PropertyBag" )
             //    return ti->addProtocol(ORO_MQUEUE_PROTOCOL_ID, new MQTemplateProtocol<PropertyBag>() );
             if ( name == "bool" )
-                return ti->addProtocol(ORO_MQUEUE_PROTOCOL_ID, new MQTemplateProtocol<bool>() );
+                return addProtocols< MQTemplateProtocol<bool> >(ti);
             if ( name == "array" )
-                return ti->addProtocol(ORO_MQUEUE_PROTOCOL_ID, new MQSerializationProtocol< std::vector<double> >() );
+                return addProtocols< MQSerializationProtocol< std::vector<double> > >(ti);
             //if ( name == "void" )
             //    return ti->addProtocol(ORO_MQUEUE_PROTOCOL_ID, new MQFallBackProtocol(false)); // warn=false
             return false;
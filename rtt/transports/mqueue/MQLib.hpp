@@ -55,4 +55,21 @@ namespace RTT {
 }
 
 #define ORO_MQUEUE_PROTOCOL_ID 2
+
+/**
+ * Same as the mqueue transport, but samples are passed through a ring in
+ * shared memory, and the message queue only wakes up the reader. It uses
+ * the marshallers of the mqueue transport, so typekits add support for it
+ * by registering their mqueue protocols with this id as well.
+ */
+#define ORO_MQUEUE_SHM_PROTOCOL_ID 4
+
+/**
+ * Same as the mqueue transport, but samples of types without a fixed
+ * layout, like std::vector, are sent in fragments when they outgrow the
+ * messages of the queue. Each message starts with a fragment header, so
+ * both ends of a connection must select this id. Typekits add support for
+ * it by registering their mqueue protocols with this id as well.
+ */
+#define ORO_MQUEUE_FRAGMENT_PROTOCOL_ID 5
 #endif
@@ -0,0 +1,191 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "MQMultiplexer.hpp"
+#include "MQSendRecv.hpp"
+#include "Dispatcher.hpp"
+#include "../../os/MutexLock.hpp"
+#include "../../Logger.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <string.h>
+
+using namespace RTT;
+using namespace RTT::mqueue;
+
+MQMultiplexer::MultiplexerMap MQMultiplexer::Multiplexers;
+os::Mutex MQMultiplexer::MultiplexersLock;
+const unsigned int MQMultiplexer::MaxHeldChannels;
+
+MQMultiplexer::shared_ptr MQMultiplexer::Open(const std::string& name, bool is_sender, int msg_size, int max_msgs)
+{
+    Logger::In in("MQMultiplexer");
+    os::MutexLock lock(MultiplexersLock);
+    MultiplexerMap::iterator it = Multiplexers.find( std::make_pair(name, is_sender) );
+    if ( it != Multiplexers.end() )
+        return it->second;
+
+    struct mq_attr mattr;
+    mattr.mq_flags = 0;
+    mattr.mq_maxmsg = max_msgs;
+    mattr.mq_msgsize = msg_size;
+    mattr.mq_curmsgs = 0;
+    // the receiver never waits for a message: the dispatcher tells it when to read.
+    int oflag = O_CREAT | O_NONBLOCK | (is_sender ? O_WRONLY : O_RDONLY);
+    mqd_t mqdes = mq_open(name.c_str(), oflag, S_IREAD | S_IWRITE, &mattr);
+    if (mqdes < 0)
+    {
+        log(Error) << "FAILED opening multiplexed queue '" << name << "' with message size " << msg_size << ", buffer size " << max_msgs
+                   << ": " << strerror(errno) << endlog();
+        return 0;
+    }
+    MQMultiplexer* mux = new MQMultiplexer(name, is_sender, mqdes);
+    Multiplexers[ std::make_pair(name, is_sender) ] = mux;
+    log(Debug) << "Opened multiplexed queue '" << name << "' with mqdes='" << mqdes << "', msg size='" << mux->mmsg_size
+               << "' an queue length='" << mux->mmax_msgs << "' for " << (is_sender ? "writing." : "reading.") << endlog();
+    return mux;
+}
+
+MQMultiplexer::MQMultiplexer(const std::string& name, bool is_sender, mqd_t mqdes)
+    : mname(name), mis_sender(is_sender), mqdes(mqdes), mmsg_size(0), mmax_msgs(1), mbuf(0),
+      mdispatched(false), mscheduler(0), mpriority(0), mcpu_affinity(0)
+{
+    // an existing queue keeps its attributes.
+    struct mq_attr mattr;
+    if ( mq_getattr(mqdes, &mattr) == 0 )
+    {
+        mmsg_size = mattr.mq_msgsize;
+        mmax_msgs = mattr.mq_maxmsg;
+    }
+    if (!mis_sender)
+        mbuf = new char[mmsg_size];
+}
+
+void MQMultiplexer::Release(shared_ptr& mux)
+{
+    os::MutexLock lock(MultiplexersLock);
+    mux = 0;
+}
+
+MQMultiplexer::~MQMultiplexer()
+{
+    // MultiplexersLock is held by Release().
+    Multiplexers.erase( std::make_pair(mname, mis_sender) );
+    if (mdispatched)
+        Dispatcher::Instance(mscheduler, mpriority, mcpu_affinity)->removeQueue(mqdes);
+    // the last sender unlinks to avoid future re-use of new readers.
+    if (mis_sender)
+        mq_unlink(mname.c_str());
+    mq_close(mqdes);
+    delete[] mbuf;
+}
+
+bool MQMultiplexer::addChannel(uint32_t id, MQSendRecv* chan)
+{
+    os::MutexLock lock(mchannels_lock);
+    if ( mchannels.count(id) )
+        return false;
+    mchannels[id] = chan;
+    // the sender connected first, while the queue was already dispatched.
+    HeldMap::iterator it = mheld.find(id);
+    if ( it != mheld.end() )
+    {
+        for (std::deque<std::string>::iterator msg = it->second.begin(); msg != it->second.end(); ++msg)
+            chan->mqDeliver(msg->data(), msg->size(), true);
+        mheld.erase(it);
+    }
+    return true;
+}
+
+void MQMultiplexer::holdInitialSample(uint32_t id, const char* msg, int size)
+{
+    HeldMap::iterator it = mheld.find(id);
+    if ( it == mheld.end() && mheld.size() == MaxHeldChannels )
+    {
+        log(Warning) << "Dropped the initial sample of channel " << id << " of multiplexed queue '" << mname << "': "
+                     << MaxHeldChannels << " channels without a receiver hold one already." << endlog();
+        return;
+    }
+    std::deque<std::string>& msgs = mheld[id];
+    msgs.push_back( std::string(msg, size) );
+    // a sample never takes more messages than the queue holds.
+    if ( (int) msgs.size() > mmax_msgs )
+        msgs.pop_front();
+}
+
+void MQMultiplexer::removeChannel(uint32_t id)
+{
+    os::MutexLock lock(mchannels_lock);
+    mchannels.erase(id);
+}
+
+void MQMultiplexer::dispatch(int scheduler, int priority, unsigned int cpu_affinity)
+{
+    os::MutexLock lock(mchannels_lock);
+    if (mdispatched)
+    {
+        if (scheduler != mscheduler || priority != mpriority || cpu_affinity != mcpu_affinity)
+            log(Warning) << "Multiplexed queue '" << mname << "' is dispatched with scheduler " << mscheduler << ", priority " << mpriority
+                         << " and cpu affinity " << mcpu_affinity << ": ignoring the dispatcher settings of a new connection." << endlog();
+        return;
+    }
+    mscheduler = scheduler;
+    mpriority = priority;
+    mcpu_affinity = cpu_affinity;
+    mdispatched = true;
+    Dispatcher::Instance(mscheduler, mpriority, mcpu_affinity)->addQueue(mqdes, this);
+}
+
+bool MQMultiplexer::signal()
+{
+    // read no more than the queue can hold, such that a busy queue
+    // does not starve the other queues of the dispatcher.
+    bool delivered = false;
+    for (int i = 0; i != mmax_msgs; ++i)
+    {
+        ssize_t bytes = mq_receive(mqdes, mbuf, mmsg_size, 0);
+        if (bytes == -1)
+            break;
+        uint32_t id;
+        if (bytes < (ssize_t) sizeof(id))
+            continue;
+        memcpy(&id, mbuf, sizeof(id));
+        os::MutexLock lock(mchannels_lock);
+        ChannelMap::iterator it = mchannels.find(id & ~InitialSample);
+        if ( it != mchannels.end() )
+            delivered = it->second->mqDeliver(mbuf + sizeof(id), bytes - sizeof(id), (id & InitialSample) != 0) || delivered;
+        else if ( id & InitialSample )
+            holdInitialSample(id & ~InitialSample, mbuf + sizeof(id), bytes - sizeof(id));
+        else
+            log(Debug) << "Dropped a sample of channel " << id << " of multiplexed queue '" << mname << "', which has no receiver." << endlog();
+    }
+    return delivered;
+}
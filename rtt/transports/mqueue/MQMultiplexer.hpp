@@ -0,0 +1,184 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef ORO_MQUEUE_MQMULTIPLEXER_HPP
+#define ORO_MQUEUE_MQMULTIPLEXER_HPP
+
+#include <mqueue.h>
+#include <stdint.h>
+#include <map>
+#include <deque>
+#include <string>
+#include "../../base/ChannelElementBase.hpp"
+#include "../../os/Mutex.hpp"
+
+namespace RTT
+{
+    namespace mqueue
+    {
+        class MQSendRecv;
+
+        /**
+         * A message queue which is shared by all connections between two
+         * processes which use the same queue name. Each message starts with
+         * the 32 bit id of the channel it belongs to, followed by a fragment
+         * of a sample of that channel.
+         *
+         * Connections select a multiplexed queue with a ConnPolicy::name_id of
+         * the form "/queue#channel", in which channel is a number which is
+         * unique for the queue.
+         *
+         * The receiving side registers itself once with a Dispatcher and
+         * hands each message to the MQSendRecv of its channel.
+         */
+        class MQMultiplexer : public base::ChannelElementBase
+        {
+        public:
+            typedef boost::intrusive_ptr<MQMultiplexer> shared_ptr;
+
+            /**
+             * Set in the channel id of the messages which carry the
+             * initial sample of a connection. Receivers hand it to the
+             * data_sample() of their channel instead of writing it, since
+             * they do not wait for it like on a queue of their own. The
+             * initial sample of a channel without a receiver is held until
+             * the receiver connects.
+             */
+            static const uint32_t InitialSample = 0x80000000u;
+
+            /**
+             * Returns the multiplexer of the queue \a name for sending or
+             * receiving, and creates it if it does not exist yet.
+             * @param name The name of the queue, starting with a '/'.
+             * @param is_sender True to open the queue for writing.
+             * @param msg_size The message size if the queue is created.
+             * @param max_msgs The queue length if the queue is created.
+             * @return null if the queue could not be opened.
+             */
+            static shared_ptr Open(const std::string& name, bool is_sender, int msg_size, int max_msgs);
+
+            /**
+             * Drops the reference \a mux, and closes the queue if this
+             * was the last one. Use this instead of resetting \a mux, such
+             * that Open() never returns a multiplexer which is being deleted.
+             */
+            static void Release(shared_ptr& mux);
+
+            /**
+             * Only called from Release().
+             */
+            ~MQMultiplexer();
+
+            /**
+             * The shared queue.
+             */
+            mqd_t getQueue() const { return mqdes; }
+
+            /**
+             * The size of the messages in the shared queue.
+             */
+            int getMessageSize() const { return mmsg_size; }
+
+            /**
+             * The number of messages the shared queue holds.
+             */
+            int getMaxMessages() const { return mmax_msgs; }
+
+            /**
+             * Routes the messages of channel \a id to \a chan, starting
+             * with the initial sample which arrived before, if any. A sender
+             * registers its channel as well, such that two connections
+             * can not send on the same channel.
+             * @return false if \a id is already in use.
+             */
+            bool addChannel(uint32_t id, MQSendRecv* chan);
+
+            /**
+             * Stops routing the messages of channel \a id.
+             */
+            void removeChannel(uint32_t id);
+
+            /**
+             * Lets a Dispatcher with the given settings watch the queue,
+             * unless one does already. Settings which differ from those of
+             * that dispatcher are ignored with a warning.
+             */
+            void dispatch(int scheduler, int priority, unsigned int cpu_affinity);
+
+            /**
+             * Called by the Dispatcher: reads the queued messages and hands
+             * each one to its channel.
+             */
+            virtual bool signal();
+
+            /**
+             * The number of channels without a receiver of which an
+             * initial sample is held.
+             */
+            static const unsigned int MaxHeldChannels = 64;
+
+        private:
+            MQMultiplexer(const std::string& name, bool is_sender, mqd_t mqdes);
+
+            /**
+             * Holds a message of the initial sample of channel \a id, which
+             * has no receiver yet. Called with mchannels_lock held.
+             */
+            void holdInitialSample(uint32_t id, const char* msg, int size);
+
+            typedef std::map<std::pair<std::string, bool>, MQMultiplexer*> MultiplexerMap;
+            static MultiplexerMap Multiplexers;
+            static os::Mutex MultiplexersLock;
+
+            typedef std::map<uint32_t, MQSendRecv*> ChannelMap;
+            ChannelMap mchannels;
+            os::Mutex mchannels_lock;
+
+            /**
+             * The messages of the initial samples of channels without a
+             * receiver. A fragmented sample takes several messages.
+             */
+            typedef std::map<uint32_t, std::deque<std::string> > HeldMap;
+            HeldMap mheld;
+
+            std::string mname;
+            bool mis_sender;
+            mqd_t mqdes;
+            int mmsg_size;
+            int mmax_msgs;
+            char* mbuf;
+
+            bool mdispatched;
+            int mscheduler, mpriority;
+            unsigned int mcpu_affinity;
+        };
+    }
+}
+
+#endif
@@ -43,16 +43,23 @@
 #include <unistd.h>
 #include <sstream>
 #include <cassert>
+#include <cstdlib>
 #include <stdexcept>
 #include <errno.h>
 #include <boost/algorithm/string.hpp>
+#include <algorithm>
+#include <fstream>
+#include <stdint.h>
 
 #include "MQSendRecv.hpp"
+#include "MQLib.hpp"
+#include "ShmRing.hpp"
 #include "../../types/TypeTransporter.hpp"
 #include "../../types/TypeMarshaller.hpp"
 #include "../../Logger.hpp"
 #include "Dispatcher.hpp"
 #include "../../base/PortInterface.hpp"
+#include "../../internal/ConnectionManager.hpp"
 #include "../../DataFlowInterface.hpp"
 #include "../../TaskContext.hpp"
 
@@ -60,9 +67,37 @@ using namespace RTT;
 using namespace RTT::detail;
 using namespace RTT::mqueue;
 
+namespace
+{
+    /**
+     * Precedes each message of a fragmented sample: the size of
+     * the sample and the offset of this fragment in it.
+     */
+    struct FragmentHeader
+    {
+        uint32_t total;
+        uint32_t offset;
+    };
+
+    /**
+     * The largest message size an unprivileged process may ask for.
+     */
+    int max_msgsize()
+    {
+        int size = 8192;
+        std::ifstream limit("/proc/sys/fs/mqueue/msgsize_max");
+        limit >> size;
+        return size;
+    }
+}
+
 
-MQSendRecv::MQSendRecv(types::TypeMarshaller const& transport) :
-    mtransport(transport), marshaller_cookie(0), buf(0), mis_sender(false), minit_done(false), max_size(0), mdata_size(0)
+MQSendRecv::MQSendRecv(types::TypeMarshaller const& transport, bool fixed_layout) :
+    mtransport(transport), marshaller_cookie(0), mqdes(-1), buf(0), mis_sender(false), minit_done(false), max_size(0), mdata_size(0), mring(0), mmax_batch(1),
+    mdispatcher_scheduler(ORO_SCHED_RT), mdispatcher_priority(os::HighestPriority), mdispatcher_cpu_affinity(0),
+    mfragment(!fixed_layout), mzero_copy(false), mmsg_size(0), massembly(0), massembly_size(0), mtotal(0), mreceived(0),
+    mheader(fixed_layout ? 0 : sizeof(FragmentHeader)), mchannel_id(0), mchannel(0), mpending(0), mpending_size(0),
+    mcoalesce(false), mstash(0), mstash_assembly(0), mstash_assembly_size(0), mskipped(0)
 {
 }
 
@@ -72,6 +107,9 @@ void MQSendRecv::setupStream(base::DataSourceBase::shared_ptr ds, base::PortInte
     Logger::In in("MQSendRecv");
 
     mdata_size = policy.data_size;
+    mdispatcher_scheduler = policy.dispatcher_scheduler;
+    mdispatcher_priority = policy.dispatcher_priority;
+    mdispatcher_cpu_affinity = policy.dispatcher_cpu_affinity;
     max_size = policy.data_size ? policy.data_size : mtransport.getSampleSize(ds);
     marshaller_cookie = mtransport.createCookie();
     mis_sender = is_sender;
@@ -91,21 +129,95 @@ void MQSendRecv::setupStream(base::DataSourceBase::shared_ptr ds, base::PortInte
     struct mq_attr mattr;
     mattr.mq_maxmsg = policy.size ? policy.size : 10;
     mattr.mq_msgsize = max_size;
+    if (policy.transport != ORO_MQUEUE_FRAGMENT_PROTOCOL_ID)
+    {
+        // the plain mqueue transport sends each sample in one message,
+        // without a header, like peers which do not know fragments.
+        mfragment = false;
+        mheader = 0;
+    }
     assert( max_size );
     if (policy.name_id[0] != '/')
         throw std::runtime_error("Could not open message queue with wrong name. Names must start with '/' and contain no more '/' after the first one.");
     if (max_size <= 0)
         throw std::runtime_error("Could not open message queue with zero message size.");
+    mmax_batch = mattr.mq_maxmsg;
+
+    std::string::size_type hash = policy.name_id.find('#');
+    if (hash != std::string::npos)
+    {
+        // a multiplexed connection: its samples are sent in fragments which
+        // are preceded by its channel id, in messages of the largest size.
+        std::string channel = policy.name_id.substr(hash + 1);
+        if (policy.transport == ORO_MQUEUE_SHM_PROTOCOL_ID)
+            throw std::runtime_error("Connections over a shared memory ring can not be multiplexed.");
+        if (channel.empty() || channel.size() > 9 || channel.find_first_not_of("0123456789") != std::string::npos)
+            throw std::runtime_error("Could not open multiplexed message queue with wrong name. Names must end with '#' and a channel number.");
+        mchannel_id = atoi(channel.c_str());
+        mfragment = true;
+        mheader = sizeof(mchannel_id) + sizeof(FragmentHeader);
+        mmux = MQMultiplexer::Open(policy.name_id.substr(0, hash), is_sender, max_msgsize(), mattr.mq_maxmsg);
+        if (!mmux)
+            throw std::runtime_error("Could not open multiplexed message queue.");
+        // a receiver registers its channel in mqReady().
+        if (is_sender && !mmux->addChannel(mchannel_id, this))
+        {
+            log(Error) << "Channel " << mchannel_id << " of multiplexed MQ '" << policy.name_id.substr(0, hash) << "' is already in use." << endlog();
+            MQMultiplexer::Release(mmux);
+            throw std::runtime_error("Could not open multiplexed message queue: channel in use.");
+        }
+        mqdes = mmux->getQueue();
+        mmsg_size = mmux->getMessageSize();
+        mmax_batch = mmux->getMaxMessages();
+        max_size = std::max(max_size + mheader, mmsg_size);
+        buf = new char[max_size];
+        memset(buf, 0, max_size); // necessary to trick valgrind
+        mqname = policy.name_id;
+        return;
+    }
+
+    if (policy.transport == ORO_MQUEUE_SHM_PROTOCOL_ID)
+    {
+        mring = new ShmRing();
+        if ( !mring->open(policy.name_id, mattr.mq_maxmsg, max_size, mis_sender) )
+        {
+            delete mring;
+            mring = 0;
+            throw std::runtime_error("Could not open shared memory ring.");
+        }
+        // the queue only holds the one pending wake-up.
+        mattr.mq_maxmsg = 1;
+        mattr.mq_msgsize = 1;
+        // the ring carries whole samples in its slots.
+        mfragment = false;
+        mheader = 0;
+    }
+    else if (mfragment)
+    {
+        // the queue is sized for the initial sample, as for any other
+        // type, and a sample which outgrows it is sent in fragments.
+        max_size += mheader;
+        mattr.mq_msgsize = std::min(max_size, max_msgsize());
+    }
     int oflag = O_CREAT;
     if (mis_sender)
         oflag |= O_WRONLY | O_NONBLOCK;
+    else if (mring)
+        oflag |= O_RDWR; // see mqReady()
     else
-        oflag |= O_RDONLY; //reading is always blocking (see mqReady() )
+        oflag |= O_RDONLY; //reading is blocking until mqReady() succeeded.
     mqdes = mq_open(policy.name_id.c_str(), oflag, S_IREAD | S_IWRITE, &mattr);
 
     if (mqdes < 0)
     {
         int the_error = errno;
+        if (mring)
+        {
+            if (mis_sender)
+                mring->unlink();
+            delete mring;
+            mring = 0;
+        }
         log(Error) << "FAILED opening '" << policy.name_id << "' with message size " << mattr.mq_msgsize << ", buffer size " << mattr.mq_maxmsg << " for "
                 << (is_sender ? "writing :" : "reading :") << endlog();
         // these are copied from the man page. They are more informative than the plain perrno() text.
@@ -145,6 +257,34 @@ void MQSendRecv::setupStream(base::DataSourceBase::shared_ptr ds, base::PortInte
 
     log(Debug) << "Opened '" << policy.name_id << "' with mqdes='" << mqdes << "', msg size='"<<mattr.mq_msgsize<<"' an queue length='"<<mattr.mq_maxmsg<<"' for " << (is_sender ? "writing." : "reading.") << endlog();
 
+    mmsg_size = mattr.mq_msgsize;
+    if (mfragment)
+    {
+        // an existing queue keeps its attributes, so we adopt its message size.
+        if (mq_getattr(mqdes, &mattr) == 0)
+        {
+            mmsg_size = mattr.mq_msgsize;
+            mmax_batch = mattr.mq_maxmsg;
+        }
+        max_size = std::max(max_size, mmsg_size);
+    }
+    // a raw sample can be received in place if the messages have exactly its size.
+    // Otherwise, the buffer must hold the messages of an existing queue.
+    if (!mfragment && !mring && !is_sender && mq_getattr(mqdes, &mattr) == 0)
+    {
+        mzero_copy = ds->getRawPointer() && mattr.mq_msgsize == (long) mtransport.getSampleSize(ds, marshaller_cookie);
+        mmsg_size = mattr.mq_msgsize;
+        max_size = std::max(max_size, mmsg_size);
+    }
+
+    // a data receiver only unmarshals the newest of the queued samples.
+    mcoalesce = !is_sender && policy.type == ConnPolicy::DATA;
+    if (mcoalesce && !mring && !mzero_copy)
+    {
+        mstash = new char[max_size];
+        memset(mstash, 0, max_size);
+    }
+
     buf = new char[max_size];
     memset(buf, 0, max_size); // necessary to trick valgrind
     mqname = policy.name_id;
@@ -154,25 +294,43 @@ MQSendRecv::~MQSendRecv()
 {
     if ( mqdes > 0)
         mq_close(mqdes);
+    delete mring;
+    delete[] massembly;
+    delete[] mstash;
+    delete[] mstash_assembly;
 }
 
 void MQSendRecv::cleanupStream()
 {
-    if (!mis_sender)
+    if (mmux)
     {
-        if (minit_done)
-        {
-            Dispatcher::Instance()->removeQueue(mqdes);
-            minit_done = false;
-        }
+        // the multiplexer closes the shared queue after its last connection.
+        if (mis_sender || minit_done)
+            mmux->removeChannel(mchannel_id);
+        minit_done = false;
+        MQMultiplexer::Release(mmux);
+        mqdes = -1;
     }
     else
     {
-        // sender unlinks to avoid future re-use of new readers.
-        mq_unlink(mqname.c_str());
+        if (!mis_sender)
+        {
+            if (minit_done)
+            {
+                Dispatcher::Instance(mdispatcher_scheduler, mdispatcher_priority, mdispatcher_cpu_affinity)->removeQueue(mqdes);
+                minit_done = false;
+            }
+        }
+        else
+        {
+            // sender unlinks to avoid future re-use of new readers.
+            mq_unlink(mqname.c_str());
+            if (mring)
+                mring->unlink();
+        }
+        // both sender and receiver close their end.
+        mq_close( mqdes);
     }
-    // both sender and receiver close their end.
-    mq_close( mqdes);
 
     if (marshaller_cookie)
         mtransport.deleteCookie(marshaller_cookie);
@@ -182,6 +340,19 @@ void MQSendRecv::cleanupStream()
         delete[] buf;
         buf = 0;
     }
+    delete mring;
+    mring = 0;
+    delete[] massembly;
+    massembly = 0;
+    massembly_size = 0;
+    delete[] mstash;
+    mstash = 0;
+    delete[] mstash_assembly;
+    mstash_assembly = 0;
+    mstash_assembly_size = 0;
+
+    if (mskipped)
+        log(Debug) << "MQ Channel '" << mqname << "' skipped " << mskipped << " samples for newer ones." << endlog();
 }
 
 
@@ -189,10 +360,28 @@ void MQSendRecv::mqNewSample(RTT::base::DataSourceBase::shared_ptr ds)
 {
     // only deduce if user did not specify it explicitly:
     if (mdata_size == 0)
-        max_size = mtransport.getSampleSize(ds);
+        max_size = mtransport.getSampleSize(ds) + mheader;
+    if (mfragment)
+        max_size = std::max(max_size, mmsg_size);
+    resizeBuffer(max_size);
+}
+
+void MQSendRecv::resizeBuffer(int size)
+{
     delete[] buf;
-    buf = new char[max_size];
-    memset(buf, 0, max_size); // necessary to trick valgrind
+    buf = new char[size];
+    memset(buf, 0, size); // necessary to trick valgrind
+    max_size = size;
+}
+
+std::pair<void const*, int> MQSendRecv::marshal(base::DataSourceBase::shared_ptr ds, void* blob, int size)
+{
+    try {
+        return mtransport.fillBlob(ds, blob, size, marshaller_cookie);
+    } catch (std::exception& e) {
+        // the serialization ran out of space.
+        return std::make_pair((void const*) 0, 0);
+    }
 }
 
 bool MQSendRecv::mqReady(base::DataSourceBase::shared_ptr ds, base::ChannelElementBase* chan)
@@ -200,6 +389,21 @@ bool MQSendRecv::mqReady(base::DataSourceBase::shared_ptr ds, base::ChannelEleme
     if (minit_done)
         return true;
 
+    if (mmux && !mis_sender)
+    {
+        // there is no initial sample to wait for: the multiplexer delivers
+        // the messages of this connection from now on.
+        mchannel = chan;
+        if ( !mmux->addChannel(mchannel_id, this) )
+        {
+            log(Error) << "Channel " << mchannel_id << " of multiplexed MQ '" << mqname << "' is already in use." << endlog();
+            return false;
+        }
+        minit_done = true;
+        mmux->dispatch(mdispatcher_scheduler, mdispatcher_priority, mdispatcher_cpu_affinity);
+        return true;
+    }
+
     if (!mis_sender)
     {
         // Try to get the initial sample
@@ -212,14 +416,38 @@ bool MQSendRecv::mqReady(base::DataSourceBase::shared_ptr ds, base::ChannelEleme
         abs_timeout.tv_sec += abs_timeout.tv_nsec / (1000*1000*1000);
         abs_timeout.tv_nsec = abs_timeout.tv_nsec % (1000*1000*1000);
         //abs_timeout.tv_sec +=1;
-        ssize_t ret = mq_timedreceive(mqdes, buf, max_size, 0, &abs_timeout);
+        const char* sample = buf;
+        ssize_t ret = mring ? mq_timedreceive(mqdes, buf, max_size, 0, &abs_timeout) : mqReceive(&abs_timeout, sample);
         if (ret != -1)
         {
-            if (mtransport.updateFromBlob((void*) buf, ret, ds, marshaller_cookie))
+            bool ok;
+            if (mring)
+            {
+                // we were woken up, the sample is in the ring.
+                mring->woken();
+                unsigned int size = 0;
+                const void* slot = mring->front(size);
+                ok = slot && mtransport.updateFromBlob(slot, size, ds, marshaller_cookie);
+                if (slot)
+                    mring->pop();
+            }
+            else
+                ok = mtransport.updateFromBlob((void*) sample, ret, ds, marshaller_cookie);
+            // from now on, mqRead() does not block, such that the
+            // channel can read until the queue is empty.
+            struct mq_attr mattr;
+            mq_getattr(mqdes, &mattr);
+            mattr.mq_flags |= O_NONBLOCK;
+            mq_setattr(mqdes, &mattr, 0);
+            // samples written in the mean time did not wake us up.
+            unsigned int next = 0;
+            if (mring && mring->front(next) && mring->wakeup())
+                mq_send(mqdes, "", 1, 0);
+            if (ok)
             {
                 minit_done = true;
                 // ok, now we can add the dispatcher.
-                Dispatcher::Instance()->addQueue(mqdes, chan);
+                Dispatcher::Instance(mdispatcher_scheduler, mdispatcher_priority, mdispatcher_cpu_affinity)->addQueue(mqdes, chan);
                 return true;
             }
             else
@@ -245,21 +473,208 @@ bool MQSendRecv::mqReady(base::DataSourceBase::shared_ptr ds, base::ChannelEleme
 
 bool MQSendRecv::mqRead(RTT::base::DataSourceBase::shared_ptr ds)
 {
+    if (mring)
+    {
+        unsigned int size = 0;
+        const void* slot = mring->front(size);
+        if (slot == 0)
+        {
+            // consume the wake-up and check again, since the writer does
+            // not wake us up for samples written before woken().
+            mq_receive(mqdes, buf, max_size, 0);
+            mring->woken();
+            slot = mring->front(size);
+            if (slot == 0)
+                return false;
+        }
+        // only the newest slot is unmarshalled.
+        while (mcoalesce && mring->size() > 1)
+        {
+            mring->pop();
+            ++mskipped;
+            slot = mring->front(size);
+        }
+        bool ok = mtransport.updateFromBlob(slot, size, ds, marshaller_cookie);
+        mring->pop();
+        return ok;
+    }
+
+    if (mzero_copy)
+    {
+        if (mq_receive(mqdes, (char*) ds->getRawPointer(), mmsg_size, 0) == -1)
+            return false;
+        // a newer sample simply overwrites this one, and a failed
+        // receive leaves it alone.
+        while (mcoalesce && mq_receive(mqdes, (char*) ds->getRawPointer(), mmsg_size, 0) != -1)
+            ++mskipped;
+        return true;
+    }
+
+    const char* sample = 0;
     int bytes = 0;
-    if ((bytes = mq_receive(mqdes, buf, max_size, 0)) == -1)
+    if ((bytes = mqReceive(0, sample)) == -1)
     {
         //log(Debug) << "Tried read on empty mq!" <<endlog();
         return false;
     }
-    if (mtransport.updateFromBlob((void*) buf, bytes, ds, marshaller_cookie))
+    // keep the complete sample we have and try to receive a newer one,
+    // which fails if the queue is empty. The queued messages may only be
+    // part of a sample, in which case we keep the one we have.
+    while (mcoalesce)
+    {
+        stash(sample);
+        const char* next = 0;
+        int next_bytes = mqReceive(0, next);
+        if (next_bytes == -1)
+            break;
+        ++mskipped;
+        sample = next;
+        bytes = next_bytes;
+    }
+    if (mtransport.updateFromBlob((void*) sample, bytes, ds, marshaller_cookie))
     {
         return true;
     }
     return false;
 }
 
-bool MQSendRecv::mqWrite(RTT::base::DataSourceBase::shared_ptr ds)
+int RTT::mqueue::getSkippedSamples(const base::PortInterface& port)
+{
+    int skipped = 0;
+    std::list<internal::ConnectionManager::ChannelDescriptor> channels = port.getManager()->getChannels();
+    for (std::list<internal::ConnectionManager::ChannelDescriptor>::iterator it = channels.begin(); it != channels.end(); ++it)
+    {
+        // the receiving stream is found upstream of the channel of an input port.
+        for (base::ChannelElementBase::shared_ptr chan = it->get<1>(); chan; chan = chan->getInput())
+        {
+            MQSendRecv* mq = dynamic_cast<MQSendRecv*>(chan.get());
+            if (mq)
+                skipped += mq->getSkippedSamples();
+        }
+    }
+    return skipped;
+}
+
+void MQSendRecv::stash(const char* sample)
+{
+    if (sample >= buf && sample < buf + max_size)
+        std::swap(buf, mstash);
+    else if (sample == massembly)
+    {
+        std::swap(massembly, mstash_assembly);
+        std::swap(massembly_size, mstash_assembly_size);
+    }
+}
+
+int MQSendRecv::mqReceive(const struct timespec* abs_timeout, const char*& sample)
+{
+    const int header = sizeof(FragmentHeader);
+    while (true)
+    {
+        const char* msg = buf;
+        ssize_t bytes;
+        if (mmux)
+        {
+            // only the message handed over by mqDeliver() is available.
+            if (mpending == 0)
+                return -1;
+            msg = mpending;
+            bytes = mpending_size;
+            mpending = 0;
+        }
+        else
+            bytes = abs_timeout ? mq_timedreceive(mqdes, buf, max_size, 0, abs_timeout) : mq_receive(mqdes, buf, max_size, 0);
+        if (bytes == -1)
+            return -1;
+        if (!mfragment)
+        {
+            sample = msg;
+            return bytes;
+        }
+        if (bytes < header)
+            continue;
+        FragmentHeader h;
+        memcpy(&h, msg, header);
+        int len = bytes - header;
+        if (h.offset == 0 && (int)h.total == len)
+        {
+            // a sample in one message is read in place.
+            mreceived = 0;
+            sample = msg + header;
+            return len;
+        }
+        if (h.offset == 0)
+        {
+            // start of a new sample, which drops the incomplete one, if any.
+            if ((int)h.total > massembly_size)
+            {
+                delete[] massembly;
+                massembly = new char[h.total];
+                massembly_size = h.total;
+            }
+            mtotal = h.total;
+            mreceived = 0;
+        }
+        else if ((int)h.offset != mreceived || (int)h.total != mtotal)
+        {
+            // a fragment got lost: skip until the next sample starts.
+            mreceived = 0;
+            continue;
+        }
+        if ((int)h.offset + len > mtotal)
+        {
+            mreceived = 0;
+            continue;
+        }
+        memcpy(massembly + h.offset, msg + header, len);
+        mreceived += len;
+        if (mreceived == mtotal)
+        {
+            mreceived = 0;
+            sample = massembly;
+            return mtotal;
+        }
+    }
+}
+
+bool MQSendRecv::mqDeliver(const char* msg, int size, bool initial)
+{
+    mpending = msg;
+    mpending_size = size;
+    bool ok = initial ? mqDataSample() : mchannel->signal();
+    mpending = 0;
+    return ok;
+}
+
+bool MQSendRecv::mqWrite(RTT::base::DataSourceBase::shared_ptr ds, bool is_data_sample)
 {
+    if (mring)
+    {
+        void* slot = mring->reserve();
+        // a full ring drops the sample, like a full message queue does.
+        if (slot == 0)
+            return true;
+        // serialize straight into the shared memory.
+        std::pair<void const*, int> blob = marshal(ds, slot, mring->getSlotSize());
+        if (blob.first == 0 || blob.second > (int) mring->getSlotSize())
+        {
+            log(Error) << "MQChannel: failed to marshal sample in a slot of "<< mring->getSlotSize() << " bytes" << endlog();
+            return false;
+        }
+        if (blob.first != slot)
+            memcpy(slot, blob.first, blob.second);
+        mring->commit(blob.second);
+        if (mring->wakeup() && mq_send(mqdes, "", 1, 0) == -1 && errno != EAGAIN)
+        {
+            log(Error) << "MQChannel "<< mqdes << " became invalid: " << strerror(errno) << endlog();
+            return false;
+        }
+        return true;
+    }
+
+    if (mfragment)
+        return mqWriteFragments(ds, is_data_sample);
+
     std::pair<void const*, int> blob = mtransport.fillBlob(ds, buf, max_size, marshaller_cookie);
     if (blob.first == 0)
     {
@@ -279,3 +694,76 @@ bool MQSendRecv::mqWrite(RTT::base::DataSourceBase::shared_ptr ds)
     return true;
 }
 
+bool MQSendRecv::mqWriteFragments(RTT::base::DataSourceBase::shared_ptr ds, bool is_data_sample)
+{
+    const int header = mheader;
+    std::pair<void const*, int> blob = marshal(ds, buf + header, max_size - header);
+    if (blob.first == 0)
+    {
+        // the sample grew beyond our buffer. This allocates, but only
+        // each time the samples reach a new maximum size.
+        int size = mtransport.getSampleSize(ds) + header;
+        if (size > max_size)
+        {
+            resizeBuffer(size);
+            blob = marshal(ds, buf + header, max_size - header);
+        }
+        if (blob.first == 0)
+        {
+            log(Error) << "MQChannel: failed to marshal sample" << endlog();
+            return false;
+        }
+    }
+    if (blob.first != buf + header)
+    {
+        // the transport returned its own copy of the sample.
+        if (blob.second > max_size - header)
+            resizeBuffer(blob.second + header);
+        memcpy(buf + header, blob.first, blob.second);
+    }
+
+    // each fragment is preceded by its header, which overwrites the tail
+    // of the previous fragment after that one was sent. On a multiplexed
+    // queue, the header starts with the channel id.
+    const uint32_t id = mchannel_id | (is_data_sample ? MQMultiplexer::InitialSample : 0);
+    const int total = blob.second;
+    const int chunk = mmsg_size - header;
+    // a sample which needs more fragments than the queue holds only
+    // arrives if the receiver reads while we send, which we can not
+    // rely on.
+    if ((total + chunk - 1) / chunk > mmax_batch)
+    {
+        log(Error) << "MQChannel "<< mqname << ": a sample of " << total << " bytes needs " << (total + chunk - 1) / chunk
+                   << " messages of " << mmsg_size << " bytes, while the queue holds " << mmax_batch << " messages." << endlog();
+        return false;
+    }
+    int offset = 0;
+    do
+    {
+        int len = std::min(chunk, total - offset);
+        FragmentHeader h;
+        h.total = total;
+        h.offset = offset;
+        if (mmux)
+            memcpy(buf + offset, &id, sizeof(id));
+        memcpy(buf + offset + header - sizeof(h), &h, sizeof(h));
+        if (mq_send(mqdes, buf + offset, len + header, 0) == -1)
+        {
+            // a full queue drops the sample, like it does with a sample in
+            // one message. If it filled up while sending, the receiver
+            // drops the fragments it got.
+            if (errno == EAGAIN)
+            {
+                if (offset != 0)
+                    log(Warning) << "MQChannel "<< mqname << " dropped a sample of " << total
+                                 << " bytes after sending " << offset << " bytes: the queue is full." << endlog();
+                return true;
+            }
+
+            log(Error) << "MQChannel "<< mqdes << " became invalid (mq length="<<mmsg_size<<", msg length="<<len + header<<"): " << strerror(errno) << endlog();
+            return false;
+        }
+        offset += len;
+    } while (offset < total);
+    return true;
+}
@@ -40,16 +40,44 @@
 #define ORO_MQSENDER_HPP_
 
 #include <mqueue.h>
+#include <stdint.h>
+#include <utility>
 #include "../../rtt-fwd.hpp"
 #include "../../base/DataSourceBase.hpp"
+#include "MQMultiplexer.hpp"
 
 namespace RTT
 {
     namespace mqueue
     {
+        class ShmRing;
+
         /**
          * Implements the sending/receiving of mqueue messages.
          * It can only be OR sender OR receiver (logical XOR).
+         *
+         * If the ConnPolicy selects ORO_MQUEUE_SHM_PROTOCOL_ID, the samples
+         * are exchanged through a ShmRing instead and the message
+         * queue only carries the wake-ups of the reader.
+         *
+         * If the ConnPolicy selects ORO_MQUEUE_FRAGMENT_PROTOCOL_ID, samples
+         * of types without a fixed layout, like std::vector, are sent in
+         * fragments when they do not fit in one message, such that they
+         * may grow after the stream was created and the message size does
+         * not need to be set for the largest sample. The queue is still
+         * sized for the initial sample, or ConnPolicy::data_size, and each
+         * message starts with an 8 byte header. A sample which needs more
+         * fragments than the queue holds can not be sent.
+         *
+         * If the ConnPolicy::name_id has the form "/queue#channel", the
+         * connection shares the queue with the other connections which use
+         * the same queue name, through an MQMultiplexer. Its samples are
+         * always sent in fragments, and the initial sample is handed to
+         * data_sample() when it arrives, instead of being waited for.
+         *
+         * The receiver of a ConnPolicy::DATA connection only unmarshals the
+         * newest of the samples which are queued when it reads, and counts
+         * the others as skipped.
          */
         class MQSendRecv
         {
@@ -100,13 +128,129 @@ namespace RTT
              * that size was zero.
              */
             int mdata_size;
+            /**
+             * The shared memory ring which carries the samples, or null
+             * if they are sent through the message queue.
+             */
+            ShmRing* mring;
+            /**
+             * The length of the queue, which is the maximum number of
+             * samples read on one wake-up of the receiver and of the
+             * fragments of a sample.
+             */
+            int mmax_batch;
+            /**
+             * The settings of the dispatcher thread of a receiver, as
+             * specified in the ConnPolicy when creating the stream.
+             */
+            int mdispatcher_scheduler;
+            int mdispatcher_priority;
+            unsigned int mdispatcher_cpu_affinity;
+            /**
+             * True if the samples are sent in fragments, which is the case
+             * for types without a fixed layout on the fragmenting transport,
+             * or on a multiplexed queue.
+             */
+            bool mfragment;
+            /**
+             * True if each message is a raw sample of exactly mmsg_size
+             * bytes, which the receiver stores straight into its sample.
+             */
+            bool mzero_copy;
+            /**
+             * The size of the messages in the queue.
+             */
+            int mmsg_size;
+            /**
+             * The buffer in which the receiver reassembles fragmented samples,
+             * and its size.
+             */
+            char* massembly;
+            int massembly_size;
+            /**
+             * The total size of the sample being reassembled and the number
+             * of its bytes received so far.
+             */
+            int mtotal;
+            int mreceived;
+            /**
+             * The size of the headers which precede each fragment that
+             * we send.
+             */
+            int mheader;
+            /**
+             * The shared queue if this connection is multiplexed, and the
+             * id of this connection in it.
+             */
+            MQMultiplexer::shared_ptr mmux;
+            uint32_t mchannel_id;
+            /**
+             * The channel element which mqDeliver() signals.
+             */
+            base::ChannelElementBase* mchannel;
+            /**
+             * The message being delivered by mqDeliver(), if any.
+             */
+            const char* mpending;
+            int mpending_size;
+            /**
+             * True if this is the receiver of a ConnPolicy::DATA connection,
+             * which skips to the newest queued sample.
+             */
+            bool mcoalesce;
+            /**
+             * Holds a complete sample while the receiver checks whether
+             * a newer one is queued: a buffer of max_size bytes and a
+             * reassembly buffer, which are swapped with buf and massembly.
+             */
+            char* mstash;
+            char* mstash_assembly;
+            int mstash_assembly_size;
+            /**
+             * The number of samples which were skipped for a newer one.
+             */
+            int mskipped;
+
+            /**
+             * Keeps \a sample, as returned by mqReceive(), from being
+             * overwritten by the next call to mqReceive().
+             */
+            void stash(const char* sample);
+
+            /**
+             * Calls mtransport.fillBlob(), but returns a null blob if the
+             * sample does not fit in \a size bytes.
+             */
+            std::pair<void const*, int> marshal(base::DataSourceBase::shared_ptr ds, void* blob, int size);
+
+            /**
+             * Replaces buf with a buffer of \a size bytes.
+             */
+            void resizeBuffer(int size);
+
+            /**
+             * Sends the sample in \a ds in one or more fragments.
+             */
+            bool mqWriteFragments(base::DataSourceBase::shared_ptr ds, bool is_data_sample);
+
+            /**
+             * Receives the next complete sample from the queue.
+             * @param abs_timeout The time until which to wait, or null
+             * to use the blocking mode of the queue.
+             * @param sample Is set to the received sample.
+             * @return The size of the sample or -1 if none was received.
+             */
+            int mqReceive(const struct timespec* abs_timeout, const char*& sample);
 
         public:
             /**
              * Create a channel element for remote data exchange.
              * @param transport The type specific object that will be used to marshal the data.
+             * @param fixed_layout True if \a transport always marshals the samples
+             * into the same number of bytes, false if they may be fragmented when
+             * they do not fit in one message.
              */
-            MQSendRecv(types::TypeMarshaller const& transport);
+            MQSendRecv(types::TypeMarshaller const& transport, bool fixed_layout = false);
 
             void setupStream(base::DataSourceBase::shared_ptr ds, base::PortInterface* port, ConnPolicy const& policy, bool is_sender);
 
@@ -141,8 +285,42 @@ namespace RTT
              * @param is_data_sample true if the sample is used for initialization, false if it is a proper write
              * @return true if it could be sent.
              */
-            bool mqWrite(base::DataSourceBase::shared_ptr ds);
+            bool mqWrite(base::DataSourceBase::shared_ptr ds, bool is_data_sample = false);
+
+            /**
+             * Called by the MQMultiplexer with a message for this
+             * connection, which is read by the channel element
+             * before this function returns.
+             * @param msg The message, without the channel id.
+             * @param size The size of \a msg.
+             * @param initial True if the message is part of the initial
+             * sample, which is read by mqDataSample().
+             * @return true if the channel element could forward a sample.
+             */
+            bool mqDeliver(const char* msg, int size, bool initial = false);
+
+            /**
+             * Called by mqDeliver() with a message of the initial sample of
+             * a multiplexed connection. The channel element reads the sample
+             * and passes it on with data_sample() once it is complete.
+             * @return true if a complete sample was passed on.
+             */
+            virtual bool mqDataSample() { return false; }
+
+            /**
+             * The number of samples of a ConnPolicy::DATA connection
+             * which were not read because a newer sample was queued.
+             */
+            int getSkippedSamples() const { return mskipped; }
         };
+
+        /**
+         * The number of samples which the mqueue connections of \a port
+         * skipped because a newer sample was queued, as counted by
+         * MQSendRecv::getSkippedSamples(). Only the connections of an
+         * input port skip samples.
+         */
+        int getSkippedSamples(const base::PortInterface& port);
     }
 }
 
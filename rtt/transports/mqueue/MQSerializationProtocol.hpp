@@ -48,9 +48,6 @@
 
 #include "MQTemplateProtocolBase.hpp"
 #include "binary_data_archive.hpp"
-#include <boost/iostreams/stream.hpp>
-#include <boost/iostreams/device/array.hpp>
-#include <iostream>
 namespace RTT
 {
 
@@ -67,13 +64,10 @@ namespace RTT
 
             virtual std::pair<void const*,int> fillBlob( base::DataSourceBase::shared_ptr source, void* blob, int size, void* cookie) const
             {
-                namespace io = boost::iostreams;
                 typename internal::DataSource<T>::shared_ptr d = boost::dynamic_pointer_cast< internal::DataSource<T> >( source );
                 if ( d ) {
-                    // we use the boost iostreams library for re-using the blob buffer in the stream object.
-                    // and the serialization library to write the data into stream.
-                    io::stream<io::array_sink>  outbuf( (char*)blob, size);
-                    binary_data_oarchive out( outbuf );
+                    // the serialization library writes the data straight into the blob.
+                    binary_data_oarchive out( blob, size );
                     out << d->rvalue();
                     return std::make_pair( blob, out.getArchiveSize() );
                 }
@@ -84,11 +78,9 @@ namespace RTT
             * Update \a target with the contents of \a blob which is an object of a \a protocol.
             */
             virtual bool updateFromBlob(const void* blob, int size, base::DataSourceBase::shared_ptr target, void* cookie) const {
-                namespace io = boost::iostreams;
                 typename internal::AssignableDataSource<T>::shared_ptr ad = internal::AssignableDataSource<T>::narrow( target.get() );
                 if ( ad ) {
-                    io::stream<io::array_source>  inbuf((const char*)blob, size);
-                    binary_data_iarchive in( inbuf );
+                    binary_data_iarchive in( blob, size );
                     in >> ad->set();
                     return true;
                 }
@@ -101,10 +93,9 @@ namespace RTT
                     log(Error) << "getSampleSize: sample has wrong type."<<endlog();
                     return 0;
                 }
-                namespace io = boost::iostreams;
-                char sink[1];
-                io::stream<io::array_sink>  outbuf(sink,1);
-                binary_data_oarchive out( outbuf, false );
+                // only counts the bytes, which does not visit the elements of
+                // arithmetic arrays.
+                binary_data_oarchive out( 0, 0, false );
                 out << tsample->get();
                 //std::cout << "sample size is "<< tsample->rvalue().size() <<" archive is " << out.getArchiveSize() <<std::endl; //disable all types but std::vector<double> for this to compile
                 return out.getArchiveSize();
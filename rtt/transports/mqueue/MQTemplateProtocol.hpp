@@ -73,6 +73,11 @@ namespace RTT
            */
           typedef T UserType;
 
+          /**
+           * A sample of \a T is always marshalled as one raw copy of sizeof(T) bytes.
+           */
+          virtual bool isFixedLayout() const { return true; }
+
           virtual std::pair<void const*,int> fillBlob( base::DataSourceBase::shared_ptr source, void* blob, int size, void* cookie) const
           {
               if ( sizeof(T) <= (unsigned int)size)
@@ -66,9 +66,18 @@ namespace RTT
            */
           typedef T UserType;
 
+          /**
+           * Returns true if the marshalled samples of \a T always have the same
+           * size and layout, such that they are sent as one message.
+           * Samples of other types may grow after the stream was created and
+           * are sent in fragments on ORO_MQUEUE_FRAGMENT_PROTOCOL_ID if they do
+           * not fit in one message.
+           */
+          virtual bool isFixedLayout() const { return false; }
+
           virtual base::ChannelElementBase::shared_ptr createStream(base::PortInterface* port, const ConnPolicy& policy, bool is_sender) const {
               try {
-                  base::ChannelElementBase::shared_ptr mq = new MQChannelElement<T>(port, *this, policy, is_sender);
+                  base::ChannelElementBase::shared_ptr mq = new MQChannelElement<T>(port, *this, policy, is_sender, isFixedLayout());
                   if ( !is_sender ) {
                       // the receiver needs a buffer to store his messages in.
                       base::ChannelElementBase::shared_ptr buf = detail::DataSourceTypeInfo<T>::getTypeInfo()->buildDataStorage(policy);
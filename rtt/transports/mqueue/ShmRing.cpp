@@ -0,0 +1,282 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "ShmRing.hpp"
+#include "../../os/CAS.hpp"
+#include "../../Logger.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+
+using namespace RTT;
+using namespace RTT::mqueue;
+
+namespace {
+    const char ShmMagic[8] = "RTTSHMR";
+}
+
+/**
+ * The start of the shared memory object. The slots follow
+ * at the first cache line after this header.
+ */
+struct ShmRing::Header
+{
+    //! ShmMagic once the ring was initialised.
+    char magic[8];
+    unsigned int slots;
+    unsigned int slot_size;
+    //! The number of slots written and read, modulo 2^32.
+    volatile unsigned int head;
+    volatile unsigned int tail;
+    //! Non-zero if the reader was woken up and did not call woken() yet.
+    volatile int pending;
+    //! The process id of the writer, or 0 if no writer opened the ring yet.
+    volatile int writer;
+};
+
+namespace {
+    const unsigned int HeaderSize = 64;
+    const unsigned int SizeField = sizeof(unsigned int);
+
+    /**
+     * The time we wait for the creator of a ring to initialise it.
+     */
+    const int OpenRetries = 100;
+    const int OpenRetryDelay = 5000; // us
+
+    /**
+     * Bounds the size of a ring, such that it can be computed in an
+     * unsigned int.
+     */
+    const unsigned int MaxSlotSize = 1u << 30;
+
+    /**
+     * Returns true if process \a pid exists.
+     */
+    bool exists(int pid)
+    {
+        return kill( pid, 0 ) == 0 || errno == EPERM;
+    }
+}
+
+ShmRing::ShmRing()
+    : mheader(0), mslots(0), mstride(0), msize(0)
+{
+}
+
+ShmRing::~ShmRing()
+{
+    if ( mheader )
+        munmap( mheader, msize );
+}
+
+bool ShmRing::open(const std::string& name, unsigned int slots, unsigned int slot_size, bool writer)
+{
+    Logger::In in("ShmRing");
+    mname = name;
+    if ( slots == 0 || slot_size == 0 || slot_size > MaxSlotSize || slots > MaxSlotSize / slot_size ) {
+        log(Error) << "Can not create shared memory '" << name << "' with " << slots << " slots of " << slot_size << " bytes." << endlog();
+        return false;
+    }
+    unsigned int stride = (SizeField + slot_size + 7) & ~7u;
+    unsigned int size = HeaderSize + slots * stride;
+
+    int fd = shm_open( name.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IREAD | S_IWRITE );
+    if ( fd < 0 && errno == EEXIST ) {
+        fd = shm_open( name.c_str(), O_RDWR, S_IREAD | S_IWRITE );
+        if ( fd < 0 ) {
+            log(Error) << "Could not open shared memory '" << name << "': " << strerror(errno) << endlog();
+            return false;
+        }
+        Attach result = attach( fd, slot_size, writer );
+        close(fd);
+        if ( result != Stale )
+            return result == Attached;
+        // a reader which still uses it lost its writer anyway, so we
+        // start over with a new one.
+        log(Warning) << "Replacing stale shared memory '" << name << "'." << endlog();
+        shm_unlink( name.c_str() );
+        return open( name, slots, slot_size, writer );
+    }
+    if ( fd < 0 ) {
+        log(Error) << "Could not open shared memory '" << name << "': " << strerror(errno) << endlog();
+        return false;
+    }
+
+    if ( ftruncate(fd, size) != 0 ) {
+        log(Error) << "Could not size shared memory '" << name << "' to " << size << " bytes: " << strerror(errno) << endlog();
+        close(fd);
+        shm_unlink( name.c_str() );
+        return false;
+    }
+    void* mem = mmap( 0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    close(fd);
+    if ( mem == MAP_FAILED ) {
+        log(Error) << "Could not map shared memory '" << name << "': " << strerror(errno) << endlog();
+        shm_unlink( name.c_str() );
+        return false;
+    }
+    mheader = static_cast<Header*>(mem);
+    msize = size;
+    mslots = static_cast<char*>(mem) + HeaderSize;
+    mstride = stride;
+    mheader->slots = slots;
+    mheader->slot_size = stride - SizeField;
+    mheader->head = 0;
+    mheader->tail = 0;
+    mheader->pending = 0;
+    mheader->writer = writer ? getpid() : 0;
+    // the other side waits for the magic.
+    __sync_synchronize();
+    memcpy( mheader->magic, ShmMagic, sizeof(ShmMagic) );
+    log(Debug) << "Created shared memory '" << name << "' with " << slots << " slots of " << mheader->slot_size << " bytes." << endlog();
+    return true;
+}
+
+ShmRing::Attach ShmRing::attach(int fd, unsigned int slot_size, bool writer)
+{
+    // wait until the creator sized and initialised it.
+    struct stat st;
+    int retries = 0;
+    while ( fstat(fd, &st) == 0 && st.st_size == 0 && ++retries != OpenRetries )
+        usleep( OpenRetryDelay );
+    if ( st.st_size < (off_t)HeaderSize || st.st_size > (off_t)~0u ) {
+        if ( writer )
+            return Stale;
+        log(Error) << "Shared memory '" << mname << "' was not initialised." << endlog();
+        return Failed;
+    }
+    unsigned int size = st.st_size;
+    void* mem = mmap( 0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    if ( mem == MAP_FAILED ) {
+        log(Error) << "Could not map shared memory '" << mname << "': " << strerror(errno) << endlog();
+        return Failed;
+    }
+    Header* header = static_cast<Header*>(mem);
+    retries = 0;
+    while ( memcmp( (const char*)header->magic, ShmMagic, sizeof(ShmMagic) ) != 0 && ++retries != OpenRetries )
+        usleep( OpenRetryDelay );
+    __sync_synchronize();
+    Attach result = Attached;
+    if ( retries == OpenRetries || header->slots == 0 || header->slot_size > MaxSlotSize
+         || header->slots > (size - HeaderSize) / (SizeField + header->slot_size) ) {
+        if ( !writer )
+            log(Error) << "Shared memory '" << mname << "' was not initialised." << endlog();
+        result = writer ? Stale : Failed;
+    } else if ( header->writer != 0 && !exists(header->writer) ) {
+        // left behind by a writer which crashed.
+        result = Stale;
+    } else if ( header->slot_size < slot_size ) {
+        log(Error) << "Shared memory '" << mname << "' has slots of " << header->slot_size
+                   << " bytes, while samples need " << slot_size << " bytes. Set the ConnPolicy::data_size of the "
+                   << (writer ? "reader" : "writer") << " to at least " << slot_size << "." << endlog();
+        result = Failed;
+    } else if ( writer && !os::CAS( &header->writer, 0, (int)getpid() ) ) {
+        log(Error) << "Shared memory '" << mname << "' is in use by the writer in process " << header->writer << "." << endlog();
+        result = Failed;
+    }
+    if ( result != Attached ) {
+        munmap( mem, size );
+        return result;
+    }
+    mheader = header;
+    msize = size;
+    mslots = static_cast<char*>(mem) + HeaderSize;
+    mstride = SizeField + header->slot_size;
+    log(Debug) << "Opened shared memory '" << mname << "' with " << header->slots
+               << " slots of " << header->slot_size << " bytes." << endlog();
+    return Attached;
+}
+
+void ShmRing::unlink()
+{
+    shm_unlink( mname.c_str() );
+}
+
+unsigned int ShmRing::getSlotSize() const
+{
+    return mheader->slot_size;
+}
+
+void* ShmRing::reserve()
+{
+    unsigned int head = mheader->head;
+    if ( head - mheader->tail >= mheader->slots )
+        return 0;
+    return mslots + (head % mheader->slots) * mstride + SizeField;
+}
+
+void ShmRing::commit(unsigned int size)
+{
+    unsigned int head = mheader->head;
+    *reinterpret_cast<unsigned int*>( mslots + (head % mheader->slots) * mstride ) = size;
+    // the slot must be complete before the reader sees it.
+    __sync_synchronize();
+    mheader->head = head + 1;
+}
+
+const void* ShmRing::front(unsigned int& size) const
+{
+    unsigned int tail = mheader->tail;
+    if ( tail == mheader->head )
+        return 0;
+    __sync_synchronize();
+    const char* slot = mslots + (tail % mheader->slots) * mstride;
+    size = *reinterpret_cast<const unsigned int*>( slot );
+    return slot + SizeField;
+}
+
+void ShmRing::pop()
+{
+    // the slot must be read before the writer re-uses it.
+    __sync_synchronize();
+    mheader->tail = mheader->tail + 1;
+}
+
+unsigned int ShmRing::size() const
+{
+    return mheader->head - mheader->tail;
+}
+
+bool ShmRing::wakeup()
+{
+    return os::CAS( &mheader->pending, 0, 1 );
+}
+
+void ShmRing::woken()
+{
+    mheader->pending = 0;
+    __sync_synchronize();
+}
@@ -0,0 +1,154 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_MQUEUE_SHMRING_HPP
+#define ORO_MQUEUE_SHMRING_HPP
+
+#include <string>
+
+namespace RTT
+{
+    namespace mqueue
+    {
+        /**
+         * A single producer, single consumer ring of fixed-size slots in
+         * POSIX shared memory. It is used by MQSendRecv to exchange
+         * samples between processes without copying them through the
+         * kernel. The ring itself does not block: the caller wakes
+         * up the reader through another channel when wakeup() says so.
+         *
+         * Both sides open() the ring with the same name. The first one
+         * creates and initialises it, the other one waits until this is
+         * done and uses the ring as it is, if its slots are large enough.
+         * A writer only replaces a ring which is stale, because the writer
+         * which initialised it crashed, or because it was never
+         * initialised.
+         */
+        class ShmRing
+        {
+            struct Header;
+            Header* mheader;
+            char* mslots;
+            unsigned int mstride;
+            unsigned int msize;
+            std::string mname;
+
+            ShmRing(const ShmRing&);
+            ShmRing& operator=(const ShmRing&);
+
+            enum Attach { Attached, Failed, Stale };
+            /**
+             * Maps the existing ring \a fd, if its slots hold \a slot_size
+             * bytes, and registers the writer.
+             */
+            Attach attach(int fd, unsigned int slot_size, bool writer);
+        public:
+            ShmRing();
+
+            /**
+             * Unmaps the ring. It is only removed from the system
+             * by unlink().
+             */
+            ~ShmRing();
+
+            /**
+             * Creates or opens the ring named \a name.
+             * @param name The name of the shared memory object, which
+             * must start with a '/'.
+             * @param slots The number of samples the ring can hold, if
+             * it is created by this call.
+             * @param slot_size The size of each sample.
+             * @param writer True for the writer. A ring has only one.
+             * @return false if the ring could not be created, if \a slots
+             * or \a slot_size is zero, if an existing ring has smaller
+             * slots than \a slot_size, or if the writer found a ring in
+             * use by another writer.
+             */
+            bool open(const std::string& name, unsigned int slots, unsigned int slot_size, bool writer);
+
+            /**
+             * Removes the ring from the system. Processes which opened
+             * it can continue to use it.
+             */
+            void unlink();
+
+            /**
+             * The size of each slot, which may be larger than
+             * requested in open().
+             */
+            unsigned int getSlotSize() const;
+
+            /**
+             * Returns the storage of the next free slot, or null if
+             * the ring is full. Only for the writer.
+             */
+            void* reserve();
+
+            /**
+             * Publishes the slot returned by reserve() to the reader.
+             * @param size The number of bytes written in the slot.
+             */
+            void commit(unsigned int size);
+
+            /**
+             * Returns the oldest slot which was not read yet, or null
+             * if the ring is empty. Only for the reader.
+             * @param size Is set to the number of bytes in the slot.
+             */
+            const void* front(unsigned int& size) const;
+
+            /**
+             * Releases the slot returned by front() to the writer.
+             */
+            void pop();
+
+            /**
+             * The number of slots which were committed but not read yet.
+             * Only for the reader.
+             */
+            unsigned int size() const;
+
+            /**
+             * Called by the writer after commit().
+             * @return true if the reader must be woken up, false if
+             * a wake-up is already pending.
+             */
+            bool wakeup();
+
+            /**
+             * Called by the reader after it was woken up, and before it
+             * reads the ring, such that the next commit() wakes it again.
+             */
+            void woken();
+        };
+    }
+}
+
+#endif
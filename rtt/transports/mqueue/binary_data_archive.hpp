@@ -59,6 +59,12 @@
  * that it doesn't allocate memory, nor during construction of the archive, nor
  * during serializing/deserializing.
  *
+ * The archives can work on a stream buffer or straight on a memory block, in
+ * which case they do not need any stream object and copy the data with memcpy.
+ * Arrays of arithmetic types, like std::vector<double>, are saved and loaded
+ * with one copy, and std::string is stored as its size followed by its
+ * characters.
+ *
  * No class information or cross-references are stored.
  *
  * This archive is header-only and does not depend on the serialization DLL.
@@ -70,6 +76,7 @@
 #include <ostream>
 #include <streambuf>
 #include <cstring>
+#include <string>
 #include <boost/version.hpp>
 #include <boost/serialization/serialization.hpp>
 #include <boost/serialization/is_bitwise_serializable.hpp>
@@ -105,7 +112,9 @@ namespace RTT
          */
         class binary_data_iarchive
         {
-            std::streambuf& m_sb;
+            std::streambuf* m_sb;
+            const char* m_buf;
+            std::size_t m_size;
             int data_read;
         public:
             typedef char Elem;
@@ -125,7 +134,7 @@ namespace RTT
              * @param os The stream to serialize from.
              */
             binary_data_iarchive(std::streambuf& bsb) :
-                m_sb(bsb), data_read(0)
+                m_sb(&bsb), m_buf(0), m_size(0), data_read(0)
             {
             }
 
@@ -134,7 +143,17 @@ namespace RTT
              * @param os The buffer to serialize from.
              */
             binary_data_iarchive(std::istream& is) :
-                m_sb(*is.rdbuf()), data_read(0)
+                m_sb(is.rdbuf()), m_buf(0), m_size(0), data_read(0)
+            {
+            }
+
+            /**
+             * Constructor from a memory block.
+             * @param buf The memory to serialize from.
+             * @param size The number of bytes in \a buf.
+             */
+            binary_data_iarchive(const void* buf, std::size_t size) :
+                m_sb(0), m_buf(static_cast<const char*>(buf)), m_size(size), data_read(0)
             {
             }
 
@@ -252,9 +271,22 @@ namespace RTT
              */
             void load_binary(void *address, std::size_t count)
             {
+                if (!m_sb) {
+                    if (count > m_size - data_read)
+                        boost::serialization::throw_exception(
+                                boost::archive::archive_exception(
+#if BOOST_VERSION >= 104400
+                                       boost::archive::archive_exception::input_stream_error));
+#else
+                                       boost::archive::archive_exception::stream_error));
+#endif
+                    std::memcpy(address, m_buf + data_read, count);
+                    data_read += count;
+                    return;
+                }
                 // note: an optimizer should eliminate the following for char files
                 std::streamsize s = count / sizeof(Elem);
-                std::streamsize scount = m_sb.sgetn(
+                std::streamsize scount = m_sb->sgetn(
                         static_cast<Elem *> (address), s);
                 if (scount != static_cast<std::streamsize> (s))
 #if BOOST_VERSION >= 104400
@@ -275,7 +307,7 @@ namespace RTT
                     //                archive_exception(archive_exception::stream_error)
                     //        );
                     Elem t;
-                    scount = m_sb.sgetn(&t, 1);
+                    scount = m_sb->sgetn(&t, 1);
                     if (scount != 1)
 #if BOOST_VERSION >= 104400
                         boost::serialization::throw_exception(
@@ -303,6 +335,32 @@ namespace RTT
                   return *this;
             }
 
+            /**
+             * Specialisation for strings, which are stored as their size
+             * followed by their characters. This only allocates if
+             * \a t has less capacity than the loaded string.
+             * @param t a string
+             * @return *this
+             */
+            binary_data_iarchive &load_a_type(std::string &t,boost::mpl::true_){
+                  std::size_t size = 0;
+                  load_binary(&size, sizeof(size));
+                  // a corrupt size must not make us allocate beyond the
+                  // memory block which holds the string.
+                  if (!m_sb && size > m_size - data_read)
+                      boost::serialization::throw_exception(
+                              boost::archive::archive_exception(
+#if BOOST_VERSION >= 104400
+                                     boost::archive::archive_exception::input_stream_error));
+#else
+                                     boost::archive::archive_exception::stream_error));
+#endif
+                  t.resize(size);
+                  if (size)
+                      load_binary(&t[0], size);
+                  return *this;
+            }
+
             /**
              * Specialisation for writing out composite types (objects).
              * @param t a serializable class or struct.
@@ -361,7 +419,9 @@ namespace RTT
          */
         class binary_data_oarchive
         {
-            std::streambuf & m_sb;
+            std::streambuf* m_sb;
+            char* m_buf;
+            std::size_t m_size;
             int data_written;
             bool mdo_save;
         public:
@@ -384,7 +444,7 @@ namespace RTT
              * in advance how much space you will need.
              */
             binary_data_oarchive(std::ostream& os,bool do_save = true) :
-                m_sb(*os.rdbuf()), data_written(0), mdo_save(do_save)
+                m_sb(os.rdbuf()), m_buf(0), m_size(0), data_written(0), mdo_save(do_save)
             {
             }
 
@@ -397,7 +457,21 @@ namespace RTT
              * in advance how much space you will need.
              */
             binary_data_oarchive(std::streambuf& sb,bool do_save = true) :
-                m_sb(sb), data_written(0), mdo_save(do_save)
+                m_sb(&sb), m_buf(0), m_size(0), data_written(0), mdo_save(do_save)
+            {
+            }
+
+            /**
+             * Constructor from a memory block.
+             * @param buf The memory to serialize to.
+             * @param size The number of bytes available in \a buf.
+             * @param do_save Set to false to not actually write nor use
+             * the given memory. Use binary_data_oarchive(0, 0, false) to know
+             * in advance how much space you will need, which does not visit
+             * the elements of arrays of arithmetic types, nor of strings.
+             */
+            binary_data_oarchive(void* buf, std::size_t size, bool do_save = true) :
+                m_sb(0), m_buf(static_cast<char*>(buf)), m_size(size), data_written(0), mdo_save(do_save)
             {
             }
 
@@ -458,8 +532,18 @@ namespace RTT
             {
                 // figure number of elements to output - round up
                 count = (count + sizeof(Elem) - 1) / sizeof(Elem);
-                if (mdo_save) {
-                    std::streamsize scount = m_sb.sputn(
+                if (mdo_save && !m_sb) {
+                    if (count > m_size - data_written)
+                        boost::serialization::throw_exception(
+                                boost::archive::archive_exception(
+#if BOOST_VERSION >= 104400
+                                        boost::archive::archive_exception::output_stream_error));
+#else
+                                        boost::archive::archive_exception::stream_error));
+#endif
+                    std::memcpy(m_buf + data_written, address, count);
+                } else if (mdo_save) {
+                    std::streamsize scount = m_sb->sputn(
                             static_cast<const Elem *> (address), count);
                     if (count != static_cast<std::size_t> (scount))
 #if BOOST_VERSION >= 104400
@@ -486,6 +570,19 @@ namespace RTT
                   return *this;
             }
 
+            /**
+             * Specialisation for strings, which are stored as their size
+             * followed by their characters.
+             * @param t a string
+             * @return *this
+             */
+            binary_data_oarchive &save_a_type(std::string const &t,boost::mpl::true_){
+                  std::size_t size = t.size();
+                  save_binary(&size, sizeof(size));
+                  save_binary(t.data(), size);
+                  return *this;
+            }
+
 #if BOOST_VERSION >= 104600
             binary_data_oarchive &save_a_type(const boost::serialization::version_type & t,boost::mpl::true_){
                 // ignored, the load function is never called, so we don't store it.
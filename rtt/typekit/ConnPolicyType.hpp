@@ -59,6 +59,9 @@ namespace boost {
             a & boost::serialization::make_nvp("transport", c.transport );
             a & boost::serialization::make_nvp("data_size", c.data_size );
             a & boost::serialization::make_nvp("name_id", c.name_id );
+            a & boost::serialization::make_nvp("dispatcher_scheduler", c.dispatcher_scheduler );
+            a & boost::serialization::make_nvp("dispatcher_priority", c.dispatcher_priority );
+            a & boost::serialization::make_nvp("dispatcher_cpu_affinity", c.dispatcher_cpu_affinity );
         }
     }
 }
@@ -31,6 +31,7 @@
 #include <internal/ListLockFree.hpp>
 #include <base/DataObject.hpp>
 #include <internal/TsPool.hpp>
+#include <ObjectPool.hpp>
 //#include <internal/SortedList.hpp>
 
 #include <os/Thread.hpp>
@@ -877,6 +878,56 @@ BOOST_AUTO_TEST_CASE( testMemoryPool )
     BOOST_CHECK_EQUAL( mpool->size(), QS);
 }
 
+BOOST_AUTO_TEST_CASE( testObjectPool )
+{
+    typedef ObjectPool<std::vector<Dummy> > Pool;
+    Pool pool(2, std::vector<Dummy>(QS));
+    BOOST_CHECK_EQUAL( pool.capacity(), 2u );
+    BOOST_CHECK_EQUAL( pool.size(), 2u );
+    {
+        Pool::Handle a = pool.allocate();
+        BOOST_REQUIRE( a.valid() );
+        BOOST_CHECK_EQUAL( a->size(), std::vector<Dummy>::size_type(QS) );
+        Pool::Handle b = pool.allocate();
+        BOOST_CHECK( b.valid() );
+        BOOST_CHECK( a.get() != b.get() );
+        // empty pool does not grow by default.
+        BOOST_CHECK( !pool.allocate().valid() );
+        BOOST_CHECK_EQUAL( pool.size(), 0u );
+
+        // the object is returned by the last handle.
+        Pool::Handle c = a;
+        BOOST_CHECK_EQUAL( c.get(), a.get() );
+        a.reset();
+        BOOST_CHECK( !a.valid() );
+        BOOST_CHECK_EQUAL( pool.size(), 0u );
+        c->push_back( Dummy() );
+        c.reset();
+        BOOST_CHECK_EQUAL( pool.size(), 1u );
+
+        // objects are recycled as-is.
+        a = pool.allocate();
+        BOOST_CHECK_EQUAL( a->size(), std::vector<Dummy>::size_type(QS + 1) );
+    }
+    BOOST_CHECK_EQUAL( pool.size(), 2u );
+
+    BOOST_CHECK( pool.reserve(3) );
+    BOOST_CHECK_EQUAL( pool.capacity(), 5u );
+    BOOST_CHECK_EQUAL( pool.size(), 5u );
+
+    pool.setGrowth(4);
+    std::vector<Pool::Handle> handles;
+    for (int i = 0; i != 6; ++i) {
+        handles.push_back( pool.allocate() );
+        BOOST_CHECK( handles.back().valid() );
+        BOOST_CHECK_EQUAL( handles.back()->size(), std::vector<Dummy>::size_type(QS) + (i == 0 ? 1 : 0) );
+    }
+    BOOST_CHECK_EQUAL( pool.capacity(), 9u );
+    BOOST_CHECK_EQUAL( pool.size(), 3u );
+    handles.clear();
+    BOOST_CHECK_EQUAL( pool.size(), 9u );
+}
+
 #if 0
 BOOST_AUTO_TEST_CASE( testSortedList )
 {
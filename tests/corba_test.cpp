@@ -814,5 +814,24 @@ BOOST_AUTO_TEST_CASE( testBufferHalfs )
     BOOST_CHECK_EQUAL( result, 4.44);
 }
 
+BOOST_AUTO_TEST_CASE( testConnPolicyConversion )
+{
+    // the mqueue dispatcher settings reach the other process.
+    ConnPolicy policy = ConnPolicy::data();
+    policy.transport = 2;
+    policy.name_id = "conversion";
+    policy.dispatcher_scheduler = ORO_SCHED_OTHER;
+    policy.dispatcher_priority = 3;
+    policy.dispatcher_cpu_affinity = 0x2;
+
+    ConnPolicy result = toRTT( toCORBA( policy ) );
+    BOOST_CHECK_EQUAL( result.type, policy.type );
+    BOOST_CHECK_EQUAL( result.transport, 2 );
+    BOOST_CHECK_EQUAL( result.name_id, "conversion" );
+    BOOST_CHECK_EQUAL( result.dispatcher_scheduler, ORO_SCHED_OTHER );
+    BOOST_CHECK_EQUAL( result.dispatcher_priority, 3 );
+    BOOST_CHECK_EQUAL( result.dispatcher_cpu_affinity, 0x2u );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -304,6 +304,38 @@ BOOST_AUTO_TEST_CASE( testConcurrentEmit )
     // Verify that all emits also caused the handler to be called.
     BOOST_CHECK_EQUAL( arunobj.count + brunobj.count + crunobj.count + drunobj.count, testConcurrentEmitHandlerCount.read() );
 }
+
+/**
+ * Emits from several threads while another thread keeps
+ * connecting and destroying handlers.
+ */
+BOOST_AUTO_TEST_CASE( testConcurrentEmitAndConnect )
+{
+    testConcurrentEmitHandlerCount.set(0);
+    Signal<void(void)> event;
+    EmitAndcount arunobj(event);
+    EmitAndcount brunobj(event);
+    EmitAndcount crunobj(event);
+    Activity atask(ORO_SCHED_OTHER, 0, 0, &arunobj);
+    Activity btask(ORO_SCHED_OTHER, 0, 0, &brunobj);
+    Activity ctask(ORO_SCHED_OTHER, 0, 0, &crunobj);
+    Handle h = event.connect( &testConcurrentEmitHandler );
+    BOOST_CHECK( h.connected() );
+    BOOST_CHECK( atask.start() );
+    BOOST_CHECK( btask.start() );
+    BOOST_CHECK( ctask.start() );
+    for (int i = 0; i < 5000; ++i) {
+        CleanupHandle sh( event.connect( boost::bind(&EventTest::listener, this) ) );
+        BOOST_CHECK( sh.connected() );
+        if ( i % 2 )
+            sh.disconnect();
+    }
+    BOOST_CHECK( atask.stop() );
+    BOOST_CHECK( btask.stop() );
+    BOOST_CHECK( ctask.stop() );
+    // The permanent handler must have seen every emit.
+    BOOST_CHECK_EQUAL( arunobj.count + brunobj.count + crunobj.count, testConcurrentEmitHandlerCount.read() );
+}
 #endif
 
 BOOST_AUTO_TEST_CASE( testBlockingTask )
@@ -20,6 +20,7 @@
 #include "unit.hpp"
 
 #include <internal/ListLocked.hpp>
+#include <internal/ListCopyOnWrite.hpp>
 #include <boost/bind/protect.hpp>
 #include <rtt-detail-fwd.hpp>
 using namespace RTT::detail;
@@ -117,5 +118,73 @@ BOOST_AUTO_TEST_CASE( test_apply )
     lld.find_if(&iffoo);
 }
 
+static void sum(double& s, double d)
+{
+    s += d;
+}
+
+BOOST_AUTO_TEST_CASE( test_copy_on_write )
+{
+    ListCopyOnWrite<double> lcow(2);
+    BOOST_CHECK( lcow.empty() );
+    BOOST_CHECK( lcow.append(1.0) );
+    BOOST_CHECK( lcow.append(2.0) );
+    BOOST_CHECK( lcow.append(3.0) ); // beyond capacity
+    BOOST_CHECK_EQUAL( lcow.size(), 3u );
+    BOOST_CHECK_EQUAL( lcow.front(), 1.0 );
+
+    double s = 0;
+    lcow.apply( boost::bind(&sum, boost::ref(s), _1) );
+    BOOST_CHECK_EQUAL( s, 6.0 );
+
+    BOOST_CHECK( lcow.erase(1.0) );
+    BOOST_CHECK( !lcow.erase(1.0) );
+    BOOST_CHECK_EQUAL( lcow.front(), 2.0 );
+    s = 0;
+    lcow.apply( boost::bind(&sum, boost::ref(s), _1) );
+    BOOST_CHECK_EQUAL( s, 5.0 );
+
+    lcow.reserve(10);
+    BOOST_CHECK_EQUAL( lcow.capacity(), 10u );
+    lcow.clear();
+    BOOST_CHECK( lcow.empty() );
+}
+
+/**
+ * Counts how many objects were default constructed, which includes
+ * every item of every snapshot allocated by ListCopyOnWrite.
+ */
+struct Counted
+{
+    static int made;
+    int v;
+    Counted() : v(0) { ++made; }
+    Counted(int i) : v(i) {}
+    bool operator==(const Counted& o) const { return v == o.v; }
+};
+int Counted::made = 0;
+
+static void modify(ListCopyOnWrite<Counted>& lcow, Counted&)
+{
+    // the list is modified while this apply() reads it.
+    for (int i = 0; i != 1000; ++i) {
+        lcow.append( Counted(i + 1) );
+        lcow.erase( Counted(i + 1) );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( test_copy_on_write_reader )
+{
+    ListCopyOnWrite<Counted> lcow(100);
+    lcow.append( Counted(0) );
+    int made = Counted::made;
+    lcow.apply( boost::bind(&modify, boost::ref(lcow), _1) );
+    BOOST_CHECK_EQUAL( lcow.size(), 1u );
+    // only the snapshot being read is held back: the others are recycled,
+    // which costs one default constructed item to clear them, instead of
+    // allocating a new snapshot of 100 items for each modification.
+    BOOST_CHECK_LT( Counted::made - made, 10 * 1000 );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -22,9 +22,16 @@
 #include "logger_test.hpp"
 
 #include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <unistd.h>
+#include <pthread.h>
 #include <boost/scoped_ptr.hpp>
 #include <Activity.hpp>
 #include <base/RunnableInterface.hpp>
+#include <BinaryLogger.hpp>
 
 using namespace boost;
 using namespace std;
@@ -33,6 +40,30 @@ using namespace RTT;
 
 class Dummy {};
 
+/**
+ * The Logger tests read back the log file, so the Logger must write
+ * it to a temporary path instead of the current directory. This runs
+ * before the Logger is created, unless the user chose a log file.
+ */
+struct TemporaryLogFile
+{
+    std::string path;
+    TemporaryLogFile() {
+        if ( getenv("ORO_LOGFILE") )
+            return;
+        std::ostringstream name;
+        name << P_tmpdir << "/orocos-core-test-" << getpid() << ".log";
+        path = name.str();
+        setenv("ORO_LOGFILE", path.c_str(), 0);
+    }
+    ~TemporaryLogFile() {
+        if ( !path.empty() )
+            std::remove( path.c_str() );
+    }
+};
+
+static TemporaryLogFile temporary_log_file;
+
 #define QS 10
 
 void
@@ -64,6 +95,26 @@ struct TestLog
 };
 
 
+static int evaluated = 0;
+
+static int countEvaluation()
+{
+    return ++evaluated;
+}
+
+static int formatted = 0;
+
+/**
+ * Counts how often it is written into a log line.
+ */
+struct Formatted {};
+
+static std::ostream& operator<<(std::ostream& os, const Formatted&)
+{
+    ++formatted;
+    return os;
+}
+
 BOOST_FIXTURE_TEST_SUITE( LoggerTestSuite, LoggerTest )
 
 BOOST_AUTO_TEST_CASE( testStartStop )
@@ -118,4 +169,243 @@ BOOST_AUTO_TEST_CASE( testThreadLog )
 
 }
 
+/**
+ * Exits with a module set and a half written line in its buffer.
+ */
+static void* leaveHalfLine(void*)
+{
+    Logger::Instance()->in("LeftModule");
+    log(Warning) << "Half written line, ";
+    return 0;
+}
+
+static void* logFreshLine(void*)
+{
+    log(Info) << "Fresh line of a new thread" << endlog();
+    return 0;
+}
+
+BOOST_AUTO_TEST_CASE( testAsyncLog )
+{
+    logger->setAsynchronous(true, 16384);
+    BOOST_CHECK( logger->isAsynchronous() );
+
+    // Two threads log concurrently, each into its own queue.
+    boost::scoped_ptr<TestLog> run( new TestLog() );
+    boost::scoped_ptr<ActivityInterface> t( new Activity(25, 0.001, 0, "ORActivity1") );
+    t->run( run.get() );
+    t->start();
+    for (int i = 0; i != 10; ++i) {
+        log(Info) << "Asynchronous line " << i << endlog();
+        usleep(20000);
+    }
+    t->stop();
+
+    // Lines are not cut to a fixed record size.
+    std::string longline( 1000, 'x' );
+    log(Info) << "Long asynchronous line " << longline << endlog();
+    usleep(200000);
+
+    // A thread which takes the buffer of an exited thread starts with
+    // the global level and module, and an empty line.
+    pthread_t thread;
+    BOOST_REQUIRE( pthread_create( &thread, 0, &leaveHalfLine, 0 ) == 0 );
+    pthread_join( thread, 0 );
+    BOOST_REQUIRE( pthread_create( &thread, 0, &logFreshLine, 0 ) == 0 );
+    pthread_join( thread, 0 );
+    usleep(200000);
+
+    // The drain thread runs every 50ms, so this burst can not fit.
+    unsigned int dropped = logger->getOverflowCount();
+    for (int i = 0; i != 1000; ++i)
+        log(Info) << "Asynchronous burst line " << i << endlog();
+    BOOST_CHECK( logger->getOverflowCount() > dropped );
+
+    logger->setAsynchronous(false);
+    BOOST_CHECK( !logger->isAsynchronous() );
+    log(Info) << "Back to synchronous logging." << endlog();
+
+    // The queued lines of both threads reached the log file.
+    std::ifstream logfile( getenv("ORO_LOGFILE") );
+    bool last = false, other = false, complete = false, fresh = false;
+    std::string line;
+    while ( std::getline( logfile, line ) ) {
+        if ( line.find("Fresh line of a new thread") != std::string::npos ) {
+            fresh = true;
+            BOOST_CHECK_MESSAGE( line.find("LeftModule") == std::string::npos
+                                 && line.find("Half written line") == std::string::npos
+                                 && line.find("Warning") == std::string::npos, line );
+        }
+        last = last || line.find("Asynchronous line 9") != std::string::npos;
+        other = other || line.find("[TLOG] Hello this is the world") != std::string::npos;
+        complete = complete || line.find("Long asynchronous line " + longline) != std::string::npos;
+    }
+    BOOST_CHECK( last );
+    BOOST_CHECK( other );
+    BOOST_CHECK( complete );
+    BOOST_CHECK( fresh );
+}
+
+BOOST_AUTO_TEST_CASE( testLogMacro )
+{
+    Logger::LogLevel orig = logger->getLogLevel();
+    logger->setLogLevel( Logger::Warning );
+
+    // Debug messages are neither shown nor written to file.
+    evaluated = 0;
+    BOOST_CHECK( !logger->mayLog( Logger::Debug ) );
+    ORO_LOG(Debug) << "Not evaluated: " << countEvaluation() << endlog();
+    BOOST_CHECK_EQUAL( evaluated, 0 );
+
+    // Info messages always go to the log file.
+    BOOST_CHECK( logger->mayLog( Logger::Info ) );
+    ORO_LOG(Info) << "Evaluated: " << countEvaluation() << endlog();
+    BOOST_CHECK_EQUAL( evaluated, 1 );
+
+    logger->setLogLevel( Logger::Debug );
+    ORO_LOG(Debug) << "Evaluated: " << countEvaluation() << endlog();
+    BOOST_CHECK_EQUAL( evaluated, 2 );
+
+    // Levels above ORO_LOG_MIN_LEVEL are removed at compile time.
+#undef ORO_LOG_MIN_LEVEL
+#define ORO_LOG_MIN_LEVEL 4
+    ORO_LOG(Debug) << "Compiled out: " << countEvaluation() << endlog();
+    ORO_LOG(Warning) << "Compiled in: " << countEvaluation() << endlog();
+    BOOST_CHECK_EQUAL( evaluated, 3 );
+#undef ORO_LOG_MIN_LEVEL
+#define ORO_LOG_MIN_LEVEL 7
+
+    logger->setLogLevel( orig );
+}
+
+BOOST_AUTO_TEST_CASE( testLogModule )
+{
+    std::string orig = logger->getLogModule();
+    {
+        Logger::In in("TestModule");
+        BOOST_CHECK_EQUAL( logger->getLogModule(), "TestModule" );
+        {
+            Logger::In in2( std::string("NestedTestModule") );
+            BOOST_CHECK_EQUAL( logger->getLogModule(), "NestedTestModule" );
+        }
+        BOOST_CHECK_EQUAL( logger->getLogModule(), "TestModule" );
+    }
+    BOOST_CHECK_EQUAL( logger->getLogModule(), orig );
+
+    // too long names are truncated.
+    std::string name( 2 * Logger::ModuleNameSize, 'x' );
+    Logger::In in( name );
+    BOOST_CHECK_EQUAL( logger->getLogModule(), name.substr(0, Logger::ModuleNameSize - 1) );
+}
+
+BOOST_AUTO_TEST_CASE( testModuleLogging )
+{
+    Logger::LogLevel orig = logger->getLogLevel();
+    logger->setLogLevel( Logger::Warning );
+    BOOST_CHECK( logger->setLogLevel( "VerboseModule", Logger::Debug ) );
+    BOOST_CHECK( logger->setLogLevel( "QuietModule", Logger::Error ) );
+    {
+        Logger::In in("VerboseModule");
+        BOOST_CHECK( logger->mayLog( Logger::Debug ) );
+    }
+    {
+        Logger::In in("QuietModule");
+        BOOST_CHECK( !logger->mayLog( Logger::Warning ) );
+        BOOST_CHECK( logger->mayLog( Logger::Error ) );
+    }
+    BOOST_CHECK( !logger->mayLog( Logger::Debug ) );
+    BOOST_CHECK( logger->mayLog( Logger::Warning ) );
+
+    // At most 5 lines in a burst, then 1 line per second.
+    BOOST_CHECK( logger->setRateLimit( "ChattyModule", 1, 5 ) );
+    {
+        Logger::In in("ChattyModule");
+        // suppressed lines are not formatted.
+        formatted = 0;
+        int admitted = 0;
+        for (int i = 0; i != 20; ++i) {
+            log(Warning) << "Chatty line " << i << Formatted() << endlog();
+            if ( i == 4 )
+                admitted = formatted;
+        }
+        BOOST_CHECK( admitted != 0 );
+        BOOST_CHECK_EQUAL( formatted, admitted );
+        evaluated = 0;
+        ORO_LOG(Warning) << "Not evaluated: " << countEvaluation() << endlog();
+        BOOST_CHECK_EQUAL( evaluated, 0 );
+        // a query is not a suppressed line.
+        BOOST_CHECK( !logger->mayLog( Logger::Warning ) );
+        BOOST_CHECK( !logger->mayLog( Logger::Warning ) );
+    }
+    BOOST_CHECK_EQUAL( logger->getSuppressedCount( "ChattyModule" ), 16u );
+    BOOST_CHECK_EQUAL( logger->getSuppressedCount( "QuietModule" ), 0u );
+
+    // the logger's thread reports the suppressed lines, also when no
+    // line of the module follows.
+    usleep(200000);
+    std::ifstream logfile( getenv("ORO_LOGFILE") );
+    bool reported = false;
+    std::string line;
+    while ( std::getline( logfile, line ) )
+        reported = reported || line.find("of module 'ChattyModule' were suppressed by its rate limit.") != std::string::npos;
+    BOOST_CHECK( reported );
+
+    BOOST_CHECK( logger->setRateLimit( "ChattyModule", 0 ) );
+    logger->setLogLevel( orig );
+}
+
+BOOST_AUTO_TEST_CASE( testBinaryLog )
+{
+    unsigned int used = 0;
+    int filled = 0;
+    {
+        BinaryLogger blog("binarylog_test.rtb", 4096);
+        BOOST_REQUIRE( blog.ready() );
+        unsigned int fmt = blog.addFormat("cycle %d took %f s: %s", Logger::Debug);
+        BOOST_CHECK( fmt != 0 );
+        used = blog.getUsed();
+        BOOST_CHECK( blog.log(fmt, 1, 0.5, "ok") );
+        BOOST_CHECK( blog.getUsed() > used );
+        BOOST_CHECK_EQUAL( blog.getDropped(), 0u );
+
+        // A full file drops records instead of overwriting them.
+        int i = 0;
+        while ( blog.log(fmt, i, 0.1 * i, std::string("filling")) )
+            ++i;
+        BOOST_CHECK( i > 10 );
+        filled = i;
+        BOOST_CHECK_EQUAL( blog.getDropped(), 1u );
+        BOOST_CHECK( blog.getUsed() <= 4096u );
+        used = blog.getUsed();
+    }
+    // The file is truncated to what was written.
+    std::ifstream f("binarylog_test.rtb", std::ios::binary);
+    BOOST_REQUIRE( f );
+    char magic[8];
+    f.read(magic, 8);
+    BOOST_CHECK_EQUAL( std::string(magic), "RTTBLOG" );
+    f.seekg(0, std::ios::end);
+    BOOST_CHECK_EQUAL( (unsigned int)f.tellg(), used );
+    f.close();
+
+#ifdef RTT_BINLOG_DECODE
+    // The decoder shows each record as a line of text.
+    FILE* decoded = popen( RTT_BINLOG_DECODE " binarylog_test.rtb", "r" );
+    BOOST_REQUIRE( decoded );
+    std::string text;
+    char chunk[256];
+    int lines = 0;
+    while ( fgets(chunk, sizeof(chunk), decoded) ) {
+        text += chunk;
+        lines += text[text.size() - 1] == '\n';
+    }
+    BOOST_CHECK_EQUAL( pclose(decoded), 0 );
+    BOOST_CHECK( text.find("[ Debug  ][thread ") != std::string::npos );
+    BOOST_CHECK( text.find("cycle 1 took 0.500000 s: ok\n") != std::string::npos );
+    BOOST_CHECK( text.find("cycle 3 took 0.300000 s: filling\n") != std::string::npos );
+    BOOST_CHECK_EQUAL( lines, filled + 1 );
+#endif
+    std::remove("binarylog_test.rtb");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -39,6 +39,11 @@ public:
     void testLogEnv();
     void testNewLog();
     void testThreadLog();
+    void testAsyncLog();
+    void testLogMacro();
+    void testLogModule();
+    void testModuleLogging();
+    void testBinaryLog();
 };
 
 #endif
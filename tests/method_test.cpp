@@ -24,10 +24,45 @@
 #include <OperationCaller.hpp>
 #include <Operation.hpp>
 #include <Service.hpp>
+#include <extras/SlaveActivity.hpp>
 
 #include "unit.hpp"
 #include "operations_fixture.hpp"
 
+/**
+ * Records the order in which sent operations are executed.
+ */
+struct PriorityRecorder
+{
+    std::vector<int> order;
+    void record(int i) { order.push_back(i); }
+};
+
+/**
+ * A component with a slow operation, counting its updateHook() calls.
+ */
+class BudgetComponent : public TaskContext
+{
+public:
+    int updates, slowcalls;
+    BudgetComponent() : TaskContext("budget"), updates(0), slowcalls(0)
+    {
+        this->addOperation("slow", &BudgetComponent::slow, this, OwnThread);
+    }
+    void slow() { usleep(2000); ++slowcalls; }
+    void updateHook() { ++updates; }
+};
+
+/**
+ * Counts the messages it gets through the single-argument process().
+ */
+struct CountingEngine : public ExecutionEngine
+{
+    int count;
+    CountingEngine() : ExecutionEngine(0), count(0) {}
+    bool process(base::DisposableInterface* c) { ++count; return ExecutionEngine::process(c); }
+};
+
 /**
  * This test suite tests the RTT::OperationCaller object's LocalOperationCaller implementation.
  */
@@ -425,4 +460,185 @@ BOOST_AUTO_TEST_CASE(testDSOperationCaller)
 
 }
 
+BOOST_AUTO_TEST_CASE(testOperationCallerCBoundArguments)
+{
+    double ret = 0.0;
+    OperationCallerC m2 = tc->provides("methods")->create("m2", tc->engine()).ret(ret);
+    BOOST_CHECK( !m2.ready() );
+    m2.bindArguments();
+    BOOST_REQUIRE( m2.ready() );
+    BOOST_REQUIRE_EQUAL( m2.getArguments().size(), 2 );
+    DataSourceBase::shared_ptr callds = m2.getCallDataSource();
+
+    AssignableDataSource<int>::shared_ptr a1 = AssignableDataSource<int>::narrow( m2.getArguments()[0].get() );
+    AssignableDataSource<double>::shared_ptr a2 = AssignableDataSource<double>::narrow( m2.getArguments()[1].get() );
+    BOOST_REQUIRE( a1 && a2 );
+
+    // new argument values are used without producing the call again.
+    a1->set(1);
+    a2->set(2.0);
+    BOOST_CHECK( m2.call() );
+    BOOST_CHECK_EQUAL( ret, -3.0 );
+    a1->set(0);
+    BOOST_CHECK( m2.call() );
+    BOOST_CHECK_EQUAL( ret, 3.0 );
+    BOOST_CHECK( m2.getCallDataSource() == callds );
+
+    // copies share the bound storage.
+    OperationCallerC copy = m2;
+    BOOST_CHECK( copy.getArguments()[0] == m2.getArguments()[0] );
+
+    // a rejected argument is not kept.
+    OperationCallerC bad = tc->provides("methods")->create("m2", tc->engine()).argC(1);
+    BOOST_CHECK_THROW( bad.argC(std::string("two")), wrong_types_of_args_exception );
+    BOOST_CHECK_EQUAL( bad.getArguments().size(), 1 );
+    bad.argC(2.0);
+    BOOST_CHECK( bad.ready() );
+}
+
+/**
+ * Compares the cost of calling trivial ClientThread operations as a script
+ * does, through their call DataSource, with a call through an OperationCaller.
+ */
+BOOST_AUTO_TEST_CASE(testClientThreadCallCost)
+{
+    const int n = 1000000;
+    OperationCaller<double(void)> m0 = tc->provides("methods")->getOperation("m0");
+    OperationCaller<double(int,double)> m2 = tc->provides("methods")->getOperation("m2");
+    DataSource<double>::shared_ptr m0ds = DataSource<double>::narrow( tc->provides("methods")->create("m0", tc->engine()).getCallDataSource().get() );
+    DataSource<double>::shared_ptr m2ds = DataSource<double>::narrow( tc->provides("methods")->create("m2", tc->engine()).argC(1).argC(2.0).getCallDataSource().get() );
+    BOOST_REQUIRE( m0.ready() && m2.ready() && m0ds && m2ds );
+    double ret = 0.0;
+
+    os::TimeService::ticks t = os::TimeService::Instance()->getTicks();
+    for (int i = 0; i != n; ++i)
+        ret += m0();
+    Seconds m0call = os::TimeService::Instance()->secondsSince(t);
+    t = os::TimeService::Instance()->getTicks();
+    for (int i = 0; i != n; ++i)
+        ret += m0ds->get();
+    Seconds m0eval = os::TimeService::Instance()->secondsSince(t);
+    BOOST_CHECK_EQUAL( ret, -2.0 * n );
+
+    ret = 0.0;
+    t = os::TimeService::Instance()->getTicks();
+    for (int i = 0; i != n; ++i)
+        ret += m2(1, 2.0);
+    Seconds m2call = os::TimeService::Instance()->secondsSince(t);
+    t = os::TimeService::Instance()->getTicks();
+    for (int i = 0; i != n; ++i)
+        ret += m2ds->get();
+    Seconds m2eval = os::TimeService::Instance()->secondsSince(t);
+    BOOST_CHECK_EQUAL( ret, -6.0 * n );
+
+    log(Info) << "ClientThread m0(): OperationCaller " << m0call * 1e9 / n << " ns/call, DataSource "
+              << m0eval * 1e9 / n << " ns/call" << endlog();
+    log(Info) << "ClientThread m2(int,double): OperationCaller " << m2call * 1e9 / n << " ns/call, DataSource "
+              << m2eval * 1e9 / n << " ns/call" << endlog();
+}
+
+BOOST_AUTO_TEST_CASE(testOperationCallerPriority)
+{
+    TaskContext prio("prio");
+    PriorityRecorder rec;
+    prio.addOperation("low", &PriorityRecorder::record, &rec, OwnThread).priority(LowPriority);
+    prio.addOperation("normal", &PriorityRecorder::record, &rec, OwnThread);
+    prio.addOperation("high", &PriorityRecorder::record, &rec, OwnThread).priority(HighPriority);
+    // messages are only processed when we execute the slave.
+    prio.setActivity( new extras::SlaveActivity() );
+    BOOST_REQUIRE( prio.start() );
+
+    OperationCaller<void(int)> low = prio.getOperation("low");
+    OperationCaller<void(int)> normal = prio.getOperation("normal");
+    OperationCaller<void(int)> high = prio.getOperation("high");
+    OperationCaller<void(int)> urgent = prio.getOperation("normal");
+    urgent.setPriority(HighPriority);
+
+    for (int i = 0; i != 15; ++i)
+        low.send(i);
+    normal.send(100);
+    high.send(200);
+    urgent.send(300);
+
+    // high lane first, then normal, then a bounded number of low messages.
+    BOOST_CHECK( prio.getActivity()->execute() );
+    BOOST_REQUIRE_EQUAL( rec.order.size(), 3 + prio.engine()->getMessageLaneBudget(LowPriority) );
+    BOOST_CHECK_EQUAL( rec.order[0], 200 );
+    BOOST_CHECK_EQUAL( rec.order[1], 300 );
+    BOOST_CHECK_EQUAL( rec.order[2], 100 );
+    for (unsigned int i = 3; i != rec.order.size(); ++i)
+        BOOST_CHECK_EQUAL( rec.order[i], int(i - 3) );
+
+    // the remaining low priority messages are processed in the next step.
+    BOOST_CHECK( prio.getActivity()->execute() );
+    BOOST_REQUIRE_EQUAL( rec.order.size(), 18 );
+    BOOST_CHECK_EQUAL( rec.order.back(), 14 );
+
+    // unbounded low lane.
+    prio.engine()->setMessageLaneBudget(LowPriority, 0);
+    for (int i = 0; i != 15; ++i)
+        low.send(i);
+    BOOST_CHECK( prio.getActivity()->execute() );
+    BOOST_CHECK_EQUAL( rec.order.size(), 33 );
+    BOOST_CHECK( prio.stop() );
+}
+
+BOOST_AUTO_TEST_CASE(testOperationCallerPriorityOverride)
+{
+    // an engine which only overrides process(c) still sees the messages
+    // of operations without a priority.
+    CountingEngine engine;
+    TaskContext prio("prio", &engine);
+    PriorityRecorder rec;
+    prio.addOperation("normal", &PriorityRecorder::record, &rec, OwnThread);
+    prio.addOperation("high", &PriorityRecorder::record, &rec, OwnThread).priority(HighPriority);
+    extras::SlaveActivity act( &engine );
+    BOOST_REQUIRE( act.start() );
+
+    OperationCaller<void(int)> normal = prio.getOperation("normal");
+    OperationCaller<void(int)> high = prio.getOperation("high");
+    normal.send(1);
+    high.send(2);
+    BOOST_CHECK_EQUAL( engine.count, 1 );
+    BOOST_CHECK( act.execute() );
+    BOOST_REQUIRE_EQUAL( rec.order.size(), 2 );
+    BOOST_CHECK_EQUAL( rec.order[0], 2 );
+    BOOST_CHECK_EQUAL( rec.order[1], 1 );
+    BOOST_CHECK( act.stop() );
+}
+
+BOOST_AUTO_TEST_CASE(testStepBudget)
+{
+    BudgetComponent bc;
+    bc.setActivity( new extras::SlaveActivity() );
+    BOOST_REQUIRE( bc.start() );
+    bc.engine()->setStepBudget(0.001);
+    BOOST_CHECK_EQUAL( bc.engine()->getStepBudget(), 0.001 );
+
+    OperationCaller<void(void)> slow = bc.getOperation("slow");
+    slow.send();
+    slow.send();
+    slow.send();
+
+    // each step, the budget is spent after one message, but updateHook() still runs.
+    BOOST_CHECK( bc.getActivity()->execute() );
+    BOOST_CHECK_EQUAL( bc.slowcalls, 1 );
+    BOOST_CHECK_EQUAL( bc.updates, 1 );
+    BOOST_CHECK_EQUAL( bc.engine()->getStepOverruns(), 1 );
+    BOOST_CHECK( bc.getActivity()->execute() );
+    BOOST_CHECK( bc.getActivity()->execute() );
+    BOOST_CHECK_EQUAL( bc.slowcalls, 3 );
+    BOOST_CHECK_EQUAL( bc.updates, 3 );
+    BOOST_CHECK_EQUAL( bc.engine()->getStepOverruns(), 3 );
+
+    // without budget, all messages are processed in one step.
+    bc.engine()->setStepBudget(0.0);
+    slow.send();
+    slow.send();
+    BOOST_CHECK( bc.getActivity()->execute() );
+    BOOST_CHECK_EQUAL( bc.slowcalls, 5 );
+    BOOST_CHECK_EQUAL( bc.engine()->getStepOverruns(), 0 );
+    BOOST_CHECK( bc.stop() );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
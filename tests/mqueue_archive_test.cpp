@@ -22,6 +22,7 @@
 #include <boost/iostreams/stream.hpp>
 #include <boost/iostreams/device/array.hpp>
 #include <boost/serialization/vector.hpp>
+#include <boost/serialization/string.hpp>
 #include <boost/archive/binary_iarchive.hpp>
 
 #include <rtt-fwd.hpp>
@@ -151,5 +152,63 @@ BOOST_AUTO_TEST_CASE( testMakeArrayBinaryDataArchive )
     BOOST_CHECK_EQUAL( stored, in.getArchiveSize() );
 }
 
+/**
+ * Archives on a memory block do not need a stream object. The
+ * size of a sample can be computed without writing it.
+ */
+BOOST_AUTO_TEST_CASE( testMemoryBinaryDataArchive )
+{
+    char sink[1000];
+    memset( sink, 0, 1000);
+    vector<double> c(10, 9.99);
+    string s("hello world");
+
+    binary_data_oarchive size( 0, 0, false );
+    size << c;
+    size << s;
+
+    rtos_enable_rt_warning();
+    binary_data_oarchive out( sink, 1000 ); // +0 alloc
+    out << c; // +0 alloc
+    out << s; // +0 alloc
+    rtos_disable_rt_warning();
+
+    unsigned int stored = out.getArchiveSize();
+    BOOST_CHECK_EQUAL( stored, size.getArchiveSize() );
+    BOOST_CHECK( stored > 10*sizeof(double) + s.size() );
+
+    c.clear();
+    c.resize(20, 0.0);
+    s.reserve(20);
+    s.clear();
+
+    rtos_enable_rt_warning();
+    binary_data_iarchive in( sink, stored ); // +0 alloc
+    in >> c; // +0 alloc
+    in >> s; // +0 alloc
+    rtos_disable_rt_warning();
+
+    BOOST_CHECK_EQUAL( c.size(), 10);
+    for(int i=0; i != 10; ++i) {
+        BOOST_CHECK_CLOSE( c[i], 9.99, 0.01);
+    }
+    BOOST_CHECK_EQUAL( s, "hello world");
+    BOOST_CHECK_EQUAL( stored, in.getArchiveSize() );
+
+    // the archives do not write or read beyond the memory block.
+    binary_data_oarchive small( sink, 5*sizeof(double) );
+    BOOST_CHECK_THROW( small << c, archive_exception );
+    binary_data_iarchive truncated( sink, stored - 1 );
+    BOOST_CHECK_THROW( truncated >> c >> s, archive_exception );
+
+    // nor allocate a string which is larger than the memory block.
+    std::size_t corrupt_size = ~std::size_t(0) >> 1;
+    memcpy( sink, &corrupt_size, sizeof(corrupt_size) );
+    binary_data_iarchive corrupt( sink, sizeof(corrupt_size) + 16 );
+    s.clear();
+    BOOST_CHECK_THROW( corrupt >> s, archive_exception );
+    BOOST_CHECK( s.empty() );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -0,0 +1,302 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+/**
+ * @file mqueue_benchmark.cpp
+ *
+ * Measures the one-way latency and the throughput of the mqueue transport
+ * between two processes on this host. The process forks into a sender and
+ * a receiver, which set up streams of std::vector<double> samples for each
+ * combination of transport (message queue or shared-memory ring), payload
+ * size (8 B to 4 MB), connection policy (DATA or BUFFER) and number of
+ * connections. Each sample carries its send time in its first element.
+ *
+ * A message queue carries a sample in fragments of at most
+ * fs.mqueue.msgsize_max bytes. Samples which need more fragments than the
+ * queue holds (fs.mqueue.msg_max) are dropped, which shows as samples that
+ * were sent but not received.
+ *
+ * In the latency run, the sender writes one sample per connection every
+ * millisecond and the receiver reports the percentiles of the one-way
+ * latency. In the throughput run, the sender writes back to back and the
+ * receiver reports the samples and bytes it got per second.
+ *
+ * Usage: mqueue-benchmark [samples]
+ * with samples the number of samples written per connection and run
+ * (default 1000, less for the large payloads).
+ */
+
+#include <os/main.h>
+#include <os/fosi.h>
+#include <os/Time.hpp>
+#include <Logger.hpp>
+#include <TaskContext.hpp>
+#include <InputPort.hpp>
+#include <OutputPort.hpp>
+#include <transports/mqueue/MQLib.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace RTT;
+
+namespace
+{
+    typedef std::vector<double> Sample;
+
+    /** One benchmark run, sent by the sender to the receiver. */
+    struct Run
+    {
+        int id;          // zero stops the receiver
+        int transport;   // ORO_MQUEUE_PROTOCOL_ID or ORO_MQUEUE_SHM_PROTOCOL_ID
+        int bytes;       // payload size
+        int type;        // ConnPolicy::DATA or BUFFER
+        int connections;
+        int samples;     // written per connection
+        int period_us;   // zero writes back to back
+    };
+
+    /** What the receiver measured during one run. */
+    struct Result
+    {
+        int received;
+        double p50, p90, p99, max;  // latency in microseconds
+        double seconds;             // from the first write to the last read
+    };
+
+    std::string queueName(pid_t sender, int run, int connection)
+    {
+        std::stringstream name;
+        name << "/rtt-bench." << sender << '.' << run << '.' << connection;
+        return name.str();
+    }
+
+    ConnPolicy policyFor(const Run& run, pid_t sender, int connection)
+    {
+        ConnPolicy policy = run.type == ConnPolicy::DATA ? ConnPolicy::data() : ConnPolicy::buffer(10);
+        policy.transport = run.transport;
+        policy.name_id = queueName(sender, run.id, connection);
+        return policy;
+    }
+
+    bool readAll(int fd, void* data, size_t size)
+    {
+        char* p = static_cast<char*>(data);
+        while (size) {
+            ssize_t n = read(fd, p, size);
+            if (n <= 0)
+                return false;
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    bool writeAll(int fd, const void* data, size_t size)
+    {
+        return write(fd, data, size) == (ssize_t) size;
+    }
+
+    /**
+     * Reads all connections when one of them has new data and
+     * records the latency of each sample.
+     */
+    class Receiver : public TaskContext
+    {
+    public:
+        std::vector< InputPort<Sample>* > ins;
+        Sample sample;
+        std::vector<double> latencies;
+        int received;
+        nsecs first_sent, last_received;
+
+        Receiver() : TaskContext("Receiver"), received(0), first_sent(0), last_received(0) {}
+
+        void updateHook()
+        {
+            for (unsigned int i = 0; i != ins.size(); ++i)
+                while (ins[i]->read(sample, false) == NewData) {
+                    nsecs now = rtos_get_time_ns();
+                    nsecs sent = (nsecs) sample[0];
+                    if (received++ == 0 || sent < first_sent)
+                        first_sent = sent;
+                    last_received = now;
+                    if (latencies.size() != latencies.capacity())
+                        latencies.push_back( (now - sent) / 1000.0 );
+                }
+        }
+    };
+
+    double percentile(const std::vector<double>& sorted, double p)
+    {
+        if (sorted.empty())
+            return 0.0;
+        return sorted[ std::min(sorted.size() - 1, (size_t)(p * sorted.size())) ];
+    }
+
+    int receiver(pid_t sender, int in, int out)
+    {
+        Receiver r;
+        Run run;
+        while ( readAll(in, &run, sizeof(run)) && run.id != 0 ) {
+            r.latencies.clear();
+            r.received = 0;
+            r.latencies.reserve(run.samples * run.connections);
+            for (int i = 0; i != run.connections; ++i) {
+                std::stringstream name;
+                name << "in" << i;
+                r.ins.push_back( new InputPort<Sample>(name.str()) );
+                r.ports()->addEventPort( *r.ins.back() );
+                if ( !r.ins.back()->createStream( policyFor(run, sender, i) ) )
+                    log(Error) << "Could not create stream " << queueName(sender, run.id, i) << endlog();
+            }
+            r.start();
+            char c = 'r';
+            writeAll(out, &c, 1);
+
+            // the sender tells us when it wrote its last sample.
+            readAll(in, &c, 1);
+            usleep(200000);
+            r.stop();
+
+            Result result;
+            std::sort(r.latencies.begin(), r.latencies.end());
+            result.received = r.received;
+            result.p50 = percentile(r.latencies, 0.50);
+            result.p90 = percentile(r.latencies, 0.90);
+            result.p99 = percentile(r.latencies, 0.99);
+            result.max = r.latencies.empty() ? 0.0 : r.latencies.back();
+            result.seconds = nsecs_to_Seconds(r.last_received - r.first_sent);
+            writeAll(out, &result, sizeof(result));
+
+            for (unsigned int i = 0; i != r.ins.size(); ++i) {
+                r.ins[i]->disconnect();
+                r.ports()->removePort( r.ins[i]->getName() );
+                delete r.ins[i];
+            }
+            r.ins.clear();
+        }
+        return 0;
+    }
+
+    int sender(int in, int out, int samples)
+    {
+        static const int sizes[] = { 8, 64, 512, 4096, 32768, 262144, 4194304 };
+        static const int connections[] = { 1, 4 };
+        static const int types[] = { ConnPolicy::DATA, ConnPolicy::BUFFER };
+        static const int transports[] = { ORO_MQUEUE_PROTOCOL_ID, ORO_MQUEUE_SHM_PROTOCOL_ID };
+
+        printf("%6s %8s %6s %5s %10s %6s %6s %9s %9s %9s %9s %10s %9s\n",
+               "trans", "bytes", "policy", "conns", "run", "sent", "recv",
+               "p50[us]", "p90[us]", "p99[us]", "max[us]", "samples/s", "MB/s");
+        int id = 0;
+        for (unsigned int x = 0; x != sizeof(transports)/sizeof(int); ++x)
+        for (unsigned int s = 0; s != sizeof(sizes)/sizeof(int); ++s)
+        for (unsigned int t = 0; t != sizeof(types)/sizeof(int); ++t)
+        for (unsigned int c = 0; c != sizeof(connections)/sizeof(int); ++c)
+        for (int period = 1000; period >= 0; period -= 1000) {
+            Run run;
+            run.id = ++id;
+            run.transport = transports[x];
+            run.bytes = sizes[s];
+            run.type = types[t];
+            run.connections = connections[c];
+            // keep the large payloads from taking forever.
+            run.samples = std::max(10, std::min(samples, (64 << 20) / run.bytes));
+            run.period_us = period;
+
+            Sample sample( std::max(1, run.bytes / (int) sizeof(double)), 0.0 );
+            std::vector< OutputPort<Sample>* > outs;
+            for (int i = 0; i != run.connections; ++i) {
+                outs.push_back( new OutputPort<Sample>("out") );
+                outs.back()->setDataSample( sample );
+                if ( !outs.back()->createStream( policyFor(run, getpid(), i) ) )
+                    log(Error) << "Could not create stream " << queueName(getpid(), run.id, i) << endlog();
+            }
+            writeAll(out, &run, sizeof(run));
+            char c;
+            readAll(in, &c, 1);
+
+            for (int n = 0; n != run.samples; ++n) {
+                for (int i = 0; i != run.connections; ++i) {
+                    sample[0] = rtos_get_time_ns();
+                    outs[i]->write( sample );
+                }
+                if (run.period_us)
+                    usleep(run.period_us);
+            }
+            writeAll(out, &c, 1);
+
+            Result result;
+            readAll(in, &result, sizeof(result));
+            double rate = result.seconds > 0 ? result.received / result.seconds : 0.0;
+            printf("%6s %8d %6s %5d %10s %6d %6d %9.1f %9.1f %9.1f %9.1f %10.0f %9.2f\n",
+                   run.transport == ORO_MQUEUE_PROTOCOL_ID ? "mqueue" : "shm", run.bytes, run.type == ConnPolicy::DATA ? "DATA" : "BUFFER", run.connections,
+                   run.period_us ? "latency" : "throughput", run.samples * run.connections, result.received,
+                   result.p50, result.p90, result.p99, result.max, rate, rate * run.bytes / 1e6);
+            fflush(stdout);
+
+            for (unsigned int i = 0; i != outs.size(); ++i) {
+                outs[i]->disconnect();
+                delete outs[i];
+            }
+        }
+        Run stop;
+        stop.id = 0;
+        writeAll(out, &stop, sizeof(stop));
+        return 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int samples = argc > 1 ? atoi(argv[1]) : 1000;
+    if (samples <= 0) {
+        fprintf(stderr, "Usage: %s [samples]\n", argv[0]);
+        return 1;
+    }
+
+    // fork before any thread exists: the sender keeps talking to the
+    // receiver over these two pipes.
+    int to_receiver[2], to_sender[2];
+    if ( pipe(to_receiver) != 0 || pipe(to_sender) != 0 ) {
+        perror("pipe");
+        return 1;
+    }
+    pid_t parent = getpid();
+    pid_t child = fork();
+    if (child < 0) {
+        perror("fork");
+        return 1;
+    }
+
+    // see test-runner.cpp
+    setenv("RTT_COMPONENT_PATH","../rtt:../../rtt", 0);
+    __os_init(argc, argv);
+    if ( log().getLogLevel() == Logger::Warning )
+        log().setLogLevel(Logger::Critical);
+
+    int res;
+    if (child == 0)
+        res = receiver(parent, to_receiver[0], to_sender[1]);
+    else {
+        res = sender(to_sender[0], to_receiver[1], samples);
+        waitpid(child, 0, 0);
+    }
+    __os_exit();
+    return res;
+}
@@ -24,7 +24,15 @@
 #include <transports/mqueue/MQLib.hpp>
 #include <transports/mqueue/MQChannelElement.hpp>
 #include <transports/mqueue/MQTemplateProtocol.hpp>
+#include <transports/mqueue/Dispatcher.hpp>
+#include <transports/mqueue/ShmRing.hpp>
 #include <os/fosi.h>
+#include <fcntl.h>
+#include <mqueue.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 using namespace std;
 using namespace RTT;
@@ -111,6 +119,33 @@ public:
     }
 };
 
+/**
+ * Gives the tests access to the receive buffer of an MQSendRecv.
+ */
+struct MQSendRecvAccess : public mqueue::MQSendRecv
+{
+    static std::string buffer(mqueue::MQSendRecv* mq) {
+        return std::string( mq->*(&MQSendRecvAccess::buf), mq->*(&MQSendRecvAccess::max_size) );
+    }
+};
+
+/**
+ * Returns the MQSendRecv of the stream of \a port, if any.
+ */
+static mqueue::MQSendRecv* getStream(base::PortInterface& port)
+{
+    std::list<internal::ConnectionManager::ChannelDescriptor> channels = port.getManager()->getChannels();
+    for (std::list<internal::ConnectionManager::ChannelDescriptor>::iterator it = channels.begin(); it != channels.end(); ++it) {
+        for (base::ChannelElementBase::shared_ptr chan = it->get<1>(); chan; chan = chan->getInput())
+            if ( mqueue::MQSendRecv* mq = dynamic_cast<mqueue::MQSendRecv*>( chan.get() ) )
+                return mq;
+        for (base::ChannelElementBase::shared_ptr chan = it->get<1>(); chan; chan = chan->getOutput())
+            if ( mqueue::MQSendRecv* mq = dynamic_cast<mqueue::MQSendRecv*>( chan.get() ) )
+                return mq;
+    }
+    return 0;
+}
+
 #define ASSERT_PORT_SIGNALLING(code, read_port) do { \
     signalled_port = 0; \
     code; \
@@ -325,6 +360,396 @@ BOOST_AUTO_TEST_CASE( testPortStreamsWrongName )
     mw2->disconnect();
 }
 
+/**
+ * Same as testPortStreams and testPortConnections, but with the
+ * shared memory transport.
+ */
+BOOST_AUTO_TEST_CASE( testShmStreams )
+{
+    policy.transport = ORO_MQUEUE_SHM_PROTOCOL_ID;
+
+    policy.type = ConnPolicy::DATA;
+    policy.pull = false;
+    policy.name_id = "/shmdata1";
+    BOOST_REQUIRE( mw1->createStream( policy ) );
+    BOOST_REQUIRE( mr2->createStream( policy ) );
+    testPortDataConnection();
+    mw1->disconnect();
+    mr2->disconnect();
+    testPortDisconnected();
+
+    policy.type = ConnPolicy::BUFFER;
+    policy.pull = false;
+    policy.size = 3;
+    policy.name_id = "";
+    BOOST_REQUIRE( mw1->createConnection(*mr2, policy) );
+    testPortBufferConnection();
+    mw1->disconnect();
+    mr2->disconnect();
+    testPortDisconnected();
+
+    // a ring left behind by a writer which crashed, with samples and a
+    // pending wake-up, is replaced by the next writer.
+    pid_t crashed = fork();
+    BOOST_REQUIRE( crashed >= 0 );
+    if ( crashed == 0 )
+        _exit(0);
+    BOOST_REQUIRE_EQUAL( waitpid( crashed, 0, 0 ), crashed );
+    int fd = shm_open( "/shmstale1", O_RDWR | O_CREAT, S_IREAD | S_IWRITE );
+    BOOST_REQUIRE( fd >= 0 );
+    const unsigned int stale[] = { 10, 12, 3, 0, 1, (unsigned int)crashed }; // slots, slot size, head, tail, pending, writer
+    BOOST_REQUIRE_EQUAL( ftruncate( fd, 64 + 10 * 16 ), 0 );
+    BOOST_REQUIRE_EQUAL( pwrite( fd, "RTTSHMR", 8, 0 ), 8 );
+    BOOST_REQUIRE_EQUAL( pwrite( fd, stale, sizeof(stale), 8 ), (ssize_t)sizeof(stale) );
+    close( fd );
+    policy.type = ConnPolicy::DATA;
+    policy.size = 0;
+    policy.name_id = "/shmstale1";
+    BOOST_REQUIRE( mw1->createStream( policy ) );
+    BOOST_REQUIRE( mr2->createStream( policy ) );
+    testPortDataConnection();
+    mw1->disconnect();
+    mr2->disconnect();
+    testPortDisconnected();
+
+    // so is a ring of another size, which has no slots.
+    fd = shm_open( "/shmstale2", O_RDWR | O_CREAT, S_IREAD | S_IWRITE );
+    BOOST_REQUIRE( fd >= 0 );
+    BOOST_REQUIRE_EQUAL( ftruncate( fd, 64 ), 0 );
+    BOOST_REQUIRE_EQUAL( pwrite( fd, "RTTSHMR", 8, 0 ), 8 );
+    close( fd );
+    policy.name_id = "/shmstale2";
+    BOOST_REQUIRE( mw1->createStream( policy ) );
+    BOOST_REQUIRE( mr2->createStream( policy ) );
+    testPortDataConnection();
+    mw1->disconnect();
+    mr2->disconnect();
+    testPortDisconnected();
+
+    // createConnection() creates the reader first, which sizes the ring
+    // from the sample of the writer. The writer uses that ring.
+    InputPort< std::vector<double> > vin("VIn");
+    OutputPort< std::vector<double> > vout("VOut");
+    vout.setDataSample( std::vector<double>(20, 3.33) );
+    policy.type = ConnPolicy::DATA;
+    policy.name_id = "/shmvector1";
+    BOOST_REQUIRE( vout.createConnection( vin, policy ) );
+    vout.write( std::vector<double>(20, 4.44) );
+    usleep(200000);
+    std::vector<double> vdata;
+    BOOST_CHECK_EQUAL( vin.read( vdata ), NewData );
+    BOOST_REQUIRE_EQUAL( vdata.size(), 20u );
+    BOOST_CHECK_EQUAL( vdata[19], 4.44 );
+    vout.disconnect();
+    vin.disconnect();
+
+    // a writer uses a ring with larger slots than it needs...
+    mqueue::ShmRing ring;
+    BOOST_REQUIRE( ring.open( "/shmvector2", 10, 4096, false ) );
+    policy.name_id = "/shmvector2";
+    BOOST_REQUIRE( vout.createStream( policy ) );
+    BOOST_CHECK_EQUAL( ring.size(), 1u );
+    BOOST_REQUIRE( vin.createStream( policy ) );
+    vout.write( std::vector<double>(20, 5.55) );
+    usleep(200000);
+    BOOST_CHECK_EQUAL( vin.read( vdata ), NewData );
+    BOOST_REQUIRE_EQUAL( vdata.size(), 20u );
+    BOOST_CHECK_EQUAL( vdata[19], 5.55 );
+    vout.disconnect();
+    vin.disconnect();
+
+    // ...but does not replace one with slots which are too small.
+    mqueue::ShmRing small;
+    BOOST_REQUIRE( small.open( "/shmvector3", 10, 16, false ) );
+    policy.name_id = "/shmvector3";
+    BOOST_CHECK( vout.createStream( policy ) == false );
+    BOOST_CHECK( vout.connected() == false );
+    small.unlink();
+}
+
+BOOST_AUTO_TEST_CASE( testManyStreams )
+{
+    // more streams than the dispatcher services in one wake-up.
+    const int n = 80;
+    std::vector< OutputPort<double>* > outs;
+    std::vector< InputPort<double>* > ins;
+
+    policy.type = ConnPolicy::DATA;
+    policy.pull = false;
+    for (int i = 0; i != n; ++i) {
+        std::stringstream name;
+        name << "/many" << i;
+        policy.name_id = name.str();
+        outs.push_back( new OutputPort<double>("out") );
+        ins.push_back( new InputPort<double>("in") );
+        BOOST_REQUIRE( outs[i]->createStream( policy ) );
+        BOOST_REQUIRE( ins[i]->createStream( policy ) );
+    }
+
+    for (int i = 0; i != n; ++i)
+        outs[i]->write( i );
+    usleep(200000);
+
+    double value = -1;
+    for (int i = 0; i != n; ++i) {
+        BOOST_CHECK_EQUAL( ins[i]->read(value), NewData );
+        BOOST_CHECK_EQUAL( value, i );
+    }
+
+    for (int i = 0; i != n; ++i) {
+        outs[i]->disconnect();
+        ins[i]->disconnect();
+        delete outs[i];
+        delete ins[i];
+    }
+}
+
+BOOST_AUTO_TEST_CASE( testBufferBurst )
+{
+    policy.type = ConnPolicy::BUFFER;
+    policy.pull = false;
+    policy.size = 10;
+    policy.name_id = "/burst1";
+    BOOST_REQUIRE( mw1->createStream( policy ) );
+    BOOST_REQUIRE( mr2->createStream( policy ) );
+
+    // a full queue is delivered in order, from as few wake-ups as possible.
+    for (int i = 0; i != 10; ++i)
+        mw1->write( i );
+    usleep(100000);
+
+    double value = -1;
+    for (int i = 0; i != 10; ++i) {
+        BOOST_CHECK_EQUAL( mr2->read(value), NewData );
+        BOOST_CHECK_EQUAL( value, i );
+    }
+    BOOST_CHECK_EQUAL( mr2->read(value), OldData );
+
+    mw1->disconnect();
+    mr2->disconnect();
+    testPortDisconnected();
+}
+
+BOOST_AUTO_TEST_CASE( testStreamDispatcher )
+{
+    // a stream with other dispatcher settings is served by its own thread.
+    policy.type = ConnPolicy::DATA;
+    policy.pull = false;
+    policy.name_id = "/dispatch1";
+    policy.dispatcher_scheduler = ORO_SCHED_OTHER;
+    policy.dispatcher_priority = os::LowestPriority;
+    BOOST_REQUIRE( mw1->createStream( policy ) );
+    BOOST_REQUIRE( mr2->createStream( policy ) );
+
+    mqueue::Dispatcher::shared_ptr dispatcher = mqueue::Dispatcher::Instance(ORO_SCHED_OTHER, os::LowestPriority);
+    BOOST_CHECK( dispatcher->isActive() );
+    BOOST_CHECK_EQUAL( dispatcher->getScheduler(), ORO_SCHED_OTHER );
+    BOOST_CHECK( dispatcher == mqueue::Dispatcher::Instance(ORO_SCHED_OTHER, os::LowestPriority) );
+
+    testPortDataConnection();
+    mw1->disconnect();
+    mr2->disconnect();
+    testPortDisconnected();
+
+    // the last reference deletes the dispatcher, and the next stream with
+    // these settings gets a new one.
+    dispatcher = 0;
+    BOOST_REQUIRE( mw1->createStream( policy ) );
+    BOOST_REQUIRE( mr2->createStream( policy ) );
+    dispatcher = mqueue::Dispatcher::Instance(ORO_SCHED_OTHER, os::LowestPriority);
+    BOOST_CHECK( dispatcher->isActive() );
+    testPortDataConnection();
+    mw1->disconnect();
+    mr2->disconnect();
+    testPortDisconnected();
+}
+
+BOOST_AUTO_TEST_CASE( testStreamDataSize )
+{
+    // messages larger than the sample are received into a buffer first.
+    policy.type = ConnPolicy::DATA;
+    policy.pull = false;
+    policy.name_id = "/datasize1";
+    policy.data_size = 64;
+    BOOST_REQUIRE( mw1->createStream( policy ) );
+    BOOST_REQUIRE( mr2->createStream( policy ) );
+    testPortDataConnection();
+    mw1->disconnect();
+    mr2->disconnect();
+    testPortDisconnected();
+}
+
+BOOST_AUTO_TEST_CASE( testZeroCopyStream )
+{
+    // messages of exactly the size of a sample are received in place,
+    // without passing through the receive buffer.
+    policy.type = ConnPolicy::DATA;
+    policy.pull = false;
+    policy.name_id = "/zerocopy1";
+    BOOST_REQUIRE( mw1->createStream( policy ) );
+    BOOST_REQUIRE( mr2->createStream( policy ) );
+    mqueue::MQSendRecv* stream = getStream( *mr2 );
+    BOOST_REQUIRE( stream );
+    std::string received = MQSendRecvAccess::buffer( stream );
+    double value = 0;
+    mw1->write( 5.0 );
+    usleep(100000);
+    BOOST_CHECK_EQUAL( mr2->read(value), NewData );
+    BOOST_CHECK_EQUAL( value, 5.0 );
+    BOOST_CHECK( MQSendRecvAccess::buffer( stream ) == received );
+    mw1->disconnect();
+    mr2->disconnect();
+    testPortDisconnected();
+
+    // messages of an existing queue with a larger size are received in
+    // the buffer first.
+    struct mq_attr mattr;
+    mattr.mq_flags = 0;
+    mattr.mq_maxmsg = 10;
+    mattr.mq_msgsize = 64;
+    mattr.mq_curmsgs = 0;
+    mqd_t mqdes = mq_open( "/zerocopy2", O_CREAT | O_RDWR, S_IREAD | S_IWRITE, &mattr );
+    BOOST_REQUIRE( mqdes >= 0 );
+    mq_close( mqdes );
+    policy.name_id = "/zerocopy2";
+    BOOST_REQUIRE( mw1->createStream( policy ) );
+    BOOST_REQUIRE( mr2->createStream( policy ) );
+    stream = getStream( *mr2 );
+    BOOST_REQUIRE( stream );
+    received = MQSendRecvAccess::buffer( stream );
+    mw1->write( 6.0 );
+    usleep(100000);
+    BOOST_CHECK_EQUAL( mr2->read(value), NewData );
+    BOOST_CHECK_EQUAL( value, 6.0 );
+    BOOST_CHECK( MQSendRecvAccess::buffer( stream ) != received );
+    mw1->disconnect();
+    mr2->disconnect();
+    testPortDisconnected();
+}
+
+BOOST_AUTO_TEST_CASE( testDataCoalescing )
+{
+    // a data receiver which falls behind only reads the newest sample:
+    // the samples are queued before the receiver connects.
+    policy.type = ConnPolicy::DATA;
+    policy.pull = false;
+    policy.name_id = "/coalesce1";
+    BOOST_REQUIRE( mw1->createStream( policy ) );
+
+    std::vector<double> data(1000, 3.33);
+    InputPort< std::vector<double> > vin("VIn");
+    OutputPort< std::vector<double> > vout("Vout");
+    vout.setDataSample( data );
+    policy.name_id = "/coalesce2";
+    BOOST_REQUIRE( vout.createStream( policy ) );
+
+    for (int i = 1; i != 6; ++i) {
+        mw1->write( i );
+        data.clear();
+        data.resize(100 * i, i);
+        vout.write( data );
+    }
+
+    policy.name_id = "/coalesce1";
+    BOOST_REQUIRE( mr2->createStream( policy ) );
+    policy.name_id = "/coalesce2";
+    BOOST_REQUIRE( vin.createStream( policy ) );
+    usleep(200000);
+
+    double value = 0;
+    BOOST_CHECK_EQUAL( mr2->read(value), NewData );
+    BOOST_CHECK_EQUAL( value, 5.0 );
+    BOOST_CHECK_EQUAL( mr2->read(value), OldData );
+    data.clear();
+    BOOST_CHECK_EQUAL( vin.read(data), NewData );
+    BOOST_REQUIRE_EQUAL( data.size(), 500 );
+    BOOST_CHECK_EQUAL( data[0], 5.0 );
+    BOOST_CHECK_EQUAL( data[499], 5.0 );
+    // the initial sample was received on connection, after which the
+    // receivers skipped 4 of the 5 written samples.
+    BOOST_CHECK_EQUAL( mqueue::getSkippedSamples( *mr2 ), 4 );
+    BOOST_CHECK_EQUAL( mqueue::getSkippedSamples( vin ), 4 );
+    BOOST_CHECK_EQUAL( mqueue::getSkippedSamples( *mw1 ), 0 );
+
+    mw1->disconnect();
+    mr2->disconnect();
+    testPortDisconnected();
+}
+
+BOOST_AUTO_TEST_CASE( testMultiplexedStreams )
+{
+    // three connections share one queue, each on its own channel.
+    policy.type = ConnPolicy::DATA;
+    policy.pull = false;
+    policy.name_id = "/mux1#1";
+    BOOST_REQUIRE( mw1->createStream( policy ) );
+    BOOST_REQUIRE( mr2->createStream( policy ) );
+    policy.name_id = "/mux1#2";
+    BOOST_REQUIRE( mw2->createStream( policy ) );
+    BOOST_REQUIRE( mr1->createStream( policy ) );
+
+    // the initial sample initialises the receiving channel.
+    std::vector<double> data(20, 3.33);
+    InputPort< std::vector<double> > vin("VIn");
+    OutputPort< std::vector<double> > vout("Vout");
+    vout.setDataSample( data );
+    policy.name_id = "/mux1#3";
+    BOOST_REQUIRE( vin.createStream( policy ) );
+    BOOST_REQUIRE( vout.createStream( policy ) );
+    usleep(100000);
+    data.clear();
+    vin.getDataSample( data );
+    BOOST_REQUIRE_EQUAL( data.size(), 20 );
+    BOOST_CHECK_CLOSE( data[19], 3.33, 0.01 );
+    BOOST_CHECK_EQUAL( vin.read(data), NoData );
+
+    // the initial sample waits for a receiver which connects later.
+    InputPort< std::vector<double> > late_in("LateIn");
+    OutputPort< std::vector<double> > early_out("EarlyOut");
+    early_out.setDataSample( std::vector<double>(30, 5.55) );
+    policy.name_id = "/mux1#4";
+    BOOST_REQUIRE( early_out.createStream( policy ) );
+    usleep(100000);
+    BOOST_REQUIRE( late_in.createStream( policy ) );
+    data.clear();
+    late_in.getDataSample( data );
+    BOOST_REQUIRE_EQUAL( data.size(), 30 );
+    BOOST_CHECK_CLOSE( data[29], 5.55, 0.01 );
+    early_out.disconnect();
+    late_in.disconnect();
+
+    // a channel carries only one connection, on both sides.
+    InputPort<double> other("other");
+    OutputPort<double> other_out("other_out");
+    policy.name_id = "/mux1#2";
+    BOOST_CHECK( !other.createStream( policy ) );
+    BOOST_CHECK( !other_out.createStream( policy ) );
+
+    testPortDataConnection();
+
+    double value = 0;
+    mw2->write( 5.0 );
+    data.clear();
+    data.resize(3000, 4.44);
+    vout.write( data );
+    usleep(200000);
+
+    BOOST_CHECK_EQUAL( mr1->read(value), NewData );
+    BOOST_CHECK_EQUAL( value, 5.0 );
+    BOOST_CHECK_EQUAL( mr2->read(value), OldData );
+    BOOST_CHECK_EQUAL( value, 2.0 );
+    data.clear();
+    BOOST_CHECK_EQUAL( vin.read(data), NewData );
+    BOOST_REQUIRE_EQUAL( data.size(), 3000 );
+    BOOST_CHECK_CLOSE( data[2999], 4.44, 0.01 );
+
+    mw1->disconnect();
+    mr2->disconnect();
+    mw2->disconnect();
+    mr1->disconnect();
+    testPortDisconnected();
+}
+
 // copied from testPortStreams
 BOOST_AUTO_TEST_CASE( testVectorTransport )
 {
@@ -382,5 +807,100 @@ BOOST_AUTO_TEST_CASE( testVectorTransport )
     rtos_disable_rt_warning();
 }
 
+BOOST_AUTO_TEST_CASE( testVectorGrowth )
+{
+    DataFlowInterface* ports  = tc->ports();
+    DataFlowInterface* ports2 = t2->ports();
+
+    std::vector<double> data(20, 3.33);
+    InputPort< std::vector<double> > vin("VIn");
+    OutputPort< std::vector<double> > vout("Vout");
+    ports->addPort(vin).doc("input port");
+    ports2->addPort(vout).doc("output port");
+
+    // the queue is sized for a vector of size 20.
+    vout.setDataSample( data );
+
+    policy.type = ConnPolicy::DATA;
+    policy.pull = false;
+    policy.transport = ORO_MQUEUE_FRAGMENT_PROTOCOL_ID;
+    policy.name_id = "/vgrowth1";
+    BOOST_REQUIRE( vout.createStream( policy ) );
+    BOOST_REQUIRE( vin.createStream( policy ) );
+    mqd_t mq = mq_open( "/vgrowth1", O_RDONLY );
+    BOOST_REQUIRE( mq >= 0 );
+    struct mq_attr attr;
+    BOOST_REQUIRE_EQUAL( mq_getattr( mq, &attr ), 0 );
+    BOOST_CHECK( attr.mq_msgsize < 1000 );
+    mq_close( mq );
+
+    // a sample which does not fit in one message is sent in fragments.
+    data.clear();
+    data.resize(100, 6.66);
+    data[99] = 9.99;
+    vout.write( data );
+    usleep(200000);
+
+    data.clear();
+    BOOST_CHECK_EQUAL( vin.read(data), NewData);
+    BOOST_REQUIRE_EQUAL( data.size(), 100);
+    BOOST_CHECK_CLOSE( data[0], 6.66, 0.01);
+    BOOST_CHECK_CLOSE( data[99], 9.99, 0.01);
+
+    // smaller samples still arrive in one message.
+    data.clear();
+    data.resize(15, 1.11);
+    vout.write( data );
+    usleep(200000);
+
+    data.clear();
+    BOOST_CHECK_EQUAL( vin.read(data), NewData);
+    BOOST_REQUIRE_EQUAL( data.size(), 15);
+    BOOST_CHECK_CLOSE( data[14], 1.11, 0.01);
+}
+
+BOOST_AUTO_TEST_CASE( testFragmentLimits )
+{
+    // a reader which does not run while the writer sends, like one on a
+    // non real-time thread on the same cpu, only gets samples of which all
+    // fragments fit in the queue.
+    std::vector<double> data(20, 3.33);
+    InputPort< std::vector<double> > vin("VIn");
+    OutputPort< std::vector<double> > vout("Vout");
+    vout.setDataSample( data );
+
+    policy.type = ConnPolicy::DATA;
+    policy.pull = false;
+    policy.transport = ORO_MQUEUE_FRAGMENT_PROTOCOL_ID;
+    policy.data_size = 4096;
+    policy.name_id = "/vlimits1";
+    policy.dispatcher_scheduler = ORO_SCHED_OTHER;
+    policy.dispatcher_priority = os::LowestPriority;
+    policy.dispatcher_cpu_affinity = 1;
+    BOOST_REQUIRE( vout.createStream( policy ) );
+    BOOST_REQUIRE( vin.createStream( policy ) );
+
+    data.clear();
+    data.resize(4000, 6.66);
+    data[3999] = 9.99;
+    vout.write( data );
+    usleep(200000);
+    data.clear();
+    BOOST_CHECK_EQUAL( vin.read(data), NewData );
+    BOOST_REQUIRE_EQUAL( data.size(), 4000 );
+    BOOST_CHECK_CLOSE( data[3999], 9.99, 0.01 );
+
+    // a sample which needs more fragments than the queue holds is refused,
+    // which removes the connection.
+    data.clear();
+    data.resize(100000, 1.11);
+    vout.write( data );
+    usleep(200000);
+    BOOST_CHECK( !vout.connected() );
+    BOOST_CHECK_EQUAL( vin.read(data), OldData );
+    BOOST_CHECK_EQUAL( data.size(), 4000 );
+    vin.disconnect();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -22,11 +22,15 @@
 #include "taskthread_test.hpp"
 
 #include <iostream>
+#include <vector>
 
 #include <extras/Activities.hpp>
 #include <extras/TimerThread.hpp>
 #include <extras/SimulationThread.hpp>
 #include <os/MainThread.hpp>
+#include <os/Mutex.hpp>
+#include <os/MutexLock.hpp>
+#include <os/TimeService.hpp>
 #include <Logger.hpp>
 #include <rtt-config.h>
 
@@ -133,6 +137,164 @@ struct TestRunner
 };
 
 
+#if defined( OROCOS_TARGET_GNULINUX ) && defined( OS_MUTEX_PRIO_INHERIT )
+static void busyWait(Seconds s)
+{
+    os::TimeService::ticks t = os::TimeService::Instance()->getTicks();
+    while ( os::TimeService::Instance()->secondsSince(t) < s )
+        ;
+}
+
+struct CpuHog
+    : public RunnableInterface
+{
+    Seconds duration;
+    CpuHog(Seconds d) : duration(d) {}
+    bool initialize() { return true; }
+    void step() {}
+    void loop() { busyWait(duration); }
+    void finalize() {}
+};
+
+struct MutexWaiter
+    : public RunnableInterface
+{
+    os::MutexInterface& m;
+    Seconds waited;
+    bool done;
+    MutexWaiter(os::MutexInterface& mutex) : m(mutex), waited(0), done(false) {}
+    bool initialize() { return true; }
+    void step() {}
+    void loop() {
+        os::TimeService::ticks t = os::TimeService::Instance()->getTicks();
+        os::MutexLock lock(m);
+        waited = os::TimeService::Instance()->secondsSince(t);
+        done = true;
+    }
+    void finalize() {}
+};
+
+/**
+ * Takes the mutex, wakes up a high priority waiter and a medium
+ * priority CPU hog and then keeps the mutex for \a hold seconds.
+ */
+struct MutexHolder
+    : public RunnableInterface
+{
+    os::MutexInterface& m;
+    Seconds hold;
+    ActivityInterface* waiter;
+    ActivityInterface* hog;
+    MutexHolder(os::MutexInterface& mutex, Seconds h, ActivityInterface* w, ActivityInterface* cpuhog)
+        : m(mutex), hold(h), waiter(w), hog(cpuhog) {}
+    bool initialize() { return true; }
+    void step() {}
+    void loop() {
+        os::MutexLock lock(m);
+        waiter->start(); // preempts us and blocks on m.
+        hog->start();    // preempts us, unless we inherited the waiter's priority.
+        busyWait(hold);
+    }
+    void finalize() {}
+};
+
+/**
+ * A mutex with the default attributes, without priority inheritance.
+ */
+struct PlainMutex
+    : public os::MutexInterface
+{
+    pthread_mutex_t m;
+    PlainMutex() { pthread_mutex_init(&m, 0); }
+    ~PlainMutex() { pthread_mutex_destroy(&m); }
+    void lock() { pthread_mutex_lock(&m); }
+    void unlock() { pthread_mutex_unlock(&m); }
+    bool trylock() { return pthread_mutex_trylock(&m) == 0; }
+    bool timedlock(Seconds) { return trylock(); }
+};
+
+/**
+ * Runs the priority inversion scenario of MutexHolder on CPU 0 and
+ * returns how long the high priority thread waited for \a m.
+ */
+static Seconds invertedWait(os::MutexInterface& m, Seconds hold, Seconds hogtime)
+{
+    MutexWaiter waiter(m);
+    CpuHog hog(hogtime);
+    Activity waitertask(ORO_SCHED_RT, 30, 0.0, 0x1, &waiter, "PIWaiter");
+    Activity hogtask(ORO_SCHED_RT, 20, 0.0, 0x1, &hog, "PIHog");
+    MutexHolder holder(m, hold, &waitertask, &hogtask);
+    Activity holdertask(ORO_SCHED_RT, 10, 0.0, 0x1, &holder, "PIHolder");
+
+    BOOST_CHECK( holdertask.start() );
+    for (int i = 0; i != 200 && !waiter.done; ++i)
+        usleep(10000);
+    BOOST_CHECK( waiter.done );
+    // let the hog finish before stopping.
+    usleep( (hogtime + hold) * 1000000 );
+    holdertask.stop();
+    hogtask.stop();
+    waitertask.stop();
+    return waiter.waited;
+}
+#endif
+
+#ifndef ORO_OS_USE_BOOST_THREAD
+/**
+ * Increments a shared counter in a very short critical section.
+ */
+struct MutexContender
+    : public RunnableInterface
+{
+    os::Mutex& m;
+    unsigned long& counter;
+    unsigned long iterations;
+    volatile bool done;
+    MutexContender(os::Mutex& mutex, unsigned long& c, unsigned long i)
+        : m(mutex), counter(c), iterations(i), done(false) {}
+    bool initialize() { return true; }
+    void step() {}
+    void loop() {
+        for (unsigned long i = 0; i != iterations; ++i) {
+            os::MutexLock lock(m);
+            ++counter;
+        }
+        done = true;
+    }
+    void finalize() {}
+};
+
+/**
+ * Lets \a threads threads increment one counter under a mutex with
+ * policy \a policy and returns the average time per increment in ns.
+ */
+static double contendedLockCost(os::MutexPolicy policy, unsigned int threads, unsigned long iterations)
+{
+    os::Mutex m(policy);
+    unsigned long counter = 0;
+    std::vector<MutexContender*> contenders;
+    std::vector<Activity*> tasks;
+    for (unsigned int i = 0; i != threads; ++i) {
+        contenders.push_back( new MutexContender(m, counter, iterations) );
+        tasks.push_back( new Activity(ORO_SCHED_OTHER, 0, 0.0, contenders.back(), "MutexContender") );
+    }
+    os::TimeService::ticks t = os::TimeService::Instance()->getTicks();
+    for (unsigned int i = 0; i != threads; ++i)
+        BOOST_CHECK( tasks[i]->start() );
+    for (unsigned int i = 0; i != threads; ++i)
+        while ( !contenders[i]->done )
+            usleep(1000);
+    Seconds elapsed = os::TimeService::Instance()->secondsSince(t);
+    for (unsigned int i = 0; i != threads; ++i) {
+        tasks[i]->stop();
+        delete tasks[i];
+        delete contenders[i];
+    }
+    BOOST_CHECK_EQUAL( counter, threads * iterations );
+    return elapsed * 1e9 / (threads * iterations);
+}
+#endif
+
 void
 ActivitiesThreadTest::setUp()
 {
@@ -444,6 +606,50 @@ BOOST_AUTO_TEST_CASE( testScheduler )
     }
 }
 
+#if defined( OROCOS_TARGET_GNULINUX ) && defined( OS_MUTEX_PRIO_INHERIT )
+/**
+ * Reproduces a priority inversion on one CPU: a low priority thread holds
+ * a mutex a high priority thread waits for, while a medium priority thread
+ * hogs the CPU. With priority inheritance, the high priority thread only
+ * waits for the mutex holder, not for the medium priority thread.
+ */
+BOOST_AUTO_TEST_CASE( testMutexPriorityInheritance )
+{
+    Activity probe(ORO_SCHED_RT, 30, 0.0, 0x1, 0, "PIProbe");
+    if ( probe.thread()->getScheduler() != ORO_SCHED_RT || probe.thread()->getPriority() != 30 ) {
+        BOOST_TEST_MESSAGE( "Skipping testMutexPriorityInheritance: no permission to use real-time priorities." );
+        return;
+    }
+    const Seconds hold = 0.05, hogtime = 0.4;
+
+    PlainMutex plain;
+    Seconds inverted = invertedWait( plain, hold, hogtime );
+    log(Info) << "Without priority inheritance, the high priority thread waited " << inverted << "s for a mutex held " << hold << "s." << endlog();
+    BOOST_CHECK_GE( inverted, hogtime );
+
+    os::Mutex m( os::BlockingMutexPolicy );
+    Seconds bounded = invertedWait( m, hold, hogtime );
+    log(Info) << "With priority inheritance, the high priority thread waited " << bounded << "s for a mutex held " << hold << "s." << endlog();
+    BOOST_CHECK_LT( bounded, hogtime / 2 );
+}
+#endif
+
+#ifndef ORO_OS_USE_BOOST_THREAD
+/**
+ * Measures short contended critical sections with blocking and
+ * adaptive mutexes for 2 to 32 threads.
+ */
+BOOST_AUTO_TEST_CASE( testMutexContention )
+{
+    const unsigned long iterations = 100000;
+    for (unsigned int threads = 2; threads <= 32; threads *= 2) {
+        double blocking = contendedLockCost( os::BlockingMutexPolicy, threads, iterations / threads );
+        double adaptive = contendedLockCost( os::AdaptiveMutexPolicy, threads, iterations / threads );
+        log(Info) << threads << " threads: blocking mutex " << blocking << " ns/lock, adaptive mutex " << adaptive << " ns/lock." << endlog();
+    }
+}
+#endif
+
 #if !defined( OROCOS_TARGET_MACOSX )
 /**
  * Checks if the rtos_task_get_pid function works properly.
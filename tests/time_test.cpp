@@ -21,8 +21,12 @@
 #include "time_test.hpp"
 #include <boost/bind.hpp>
 #include <os/Timer.hpp>
+#include <os/fosi.h>
 #include <rtt-detail-fwd.hpp>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <pthread.h>
 
 #define EPSILON 0.000000002
 
@@ -167,6 +171,107 @@ BOOST_AUTO_TEST_CASE( testTimeProgress )
 
 }
 
+/**
+ * Reads the fast clock until stopped, and checks each time against
+ * the system clock read just before and after it.
+ */
+struct ClockReader
+{
+    volatile bool stop;
+    bool agrees;
+    ClockReader() : stop(false), agrees(true) {}
+};
+
+static void* readClock(void* arg)
+{
+    ClockReader* r = static_cast<ClockReader*>(arg);
+    TimeService* ts = TimeService::Instance();
+    while ( !r->stop ) {
+        nsecs before = rtos_get_time_ns();
+        nsecs now = ts->getNSecs();
+        nsecs after = rtos_get_time_ns();
+        r->agrees = r->agrees && now > before - 1000000 && now < after + 1000000;
+    }
+    return 0;
+}
+
+/**
+ * Checks the fast clock against the system clock and reports the
+ * cost of reading the time with and without it.
+ */
+BOOST_AUTO_TEST_CASE( testFastClock )
+{
+    const int reads = 1000000;
+    hbg->enableFastClock( false );
+    BOOST_CHECK( !hbg->fastClockEnabled() );
+    nsecs start = rtos_get_time_ns();
+    for (int i = 0; i != reads; ++i)
+        hbg->getTicks();
+    double system_cost = double(rtos_get_time_ns() - start) / reads;
+    BOOST_TEST_MESSAGE( "TimeService::getTicks() system clock: " << system_cost << " ns/call" );
+
+    if ( !hbg->enableFastClock( true ) ) {
+        BOOST_TEST_MESSAGE( "No invariant TSC: fast clock not tested." );
+        BOOST_CHECK( !hbg->fastClockEnabled() );
+        return;
+    }
+    BOOST_CHECK( hbg->fastClockEnabled() );
+    start = rtos_get_time_ns();
+    TimeService::ticks prev = hbg->getTicks();
+    bool monotonic = true;
+    for (int i = 0; i != reads; ++i) {
+        TimeService::ticks now = hbg->getTicks();
+        monotonic = monotonic && now >= prev;
+        prev = now;
+    }
+    double fast_cost = double(rtos_get_time_ns() - start) / reads;
+    BOOST_TEST_MESSAGE( "TimeService::getTicks() fast clock: " << fast_cost << " ns/call" );
+    BOOST_CHECK( monotonic );
+
+    // Both clocks must agree within a millisecond, also after a while.
+    BOOST_CHECK_SMALL( double(hbg->getNSecs() - rtos_get_time_ns()), 1000000.0 );
+    usleep(100000);
+    BOOST_CHECK_SMALL( double(hbg->getNSecs() - rtos_get_time_ns()), 1000000.0 );
+
+    // The fast clock is re-anchored every second, without going back in
+    // time, after which it follows the system clock more closely. Other
+    // threads never read a half re-anchored calibration.
+    ClockReader readers[2];
+    pthread_t threads[2];
+    for (int i = 0; i != 2; ++i)
+        BOOST_REQUIRE( pthread_create( &threads[i], 0, &readClock, &readers[i] ) == 0 );
+    nsecs last = hbg->getNSecs();
+    monotonic = true;
+    for (int i = 0; i != 35; ++i) {
+        usleep(100000);
+        nsecs now = hbg->getNSecs();
+        monotonic = monotonic && now >= last;
+        last = now;
+        BOOST_CHECK_SMALL( double(now - rtos_get_time_ns()), 1000000.0 );
+    }
+    BOOST_CHECK( monotonic );
+    for (int i = 0; i != 2; ++i) {
+        readers[i].stop = true;
+        pthread_join( threads[i], 0 );
+        BOOST_CHECK( readers[i].agrees );
+    }
+    double offset = 1e9;
+    for (int i = 0; i != 10; ++i)
+        offset = std::min( offset, std::abs( double(hbg->getNSecs() - rtos_get_time_ns()) ) );
+    BOOST_TEST_MESSAGE( "Fast clock offset after re-anchoring: " << offset << " ns" );
+    BOOST_CHECK_SMALL( offset, 20000.0 );
+
+    // Stopping and restarting time works as before.
+    hbg->enableSystemClock( false );
+    TimeService::ticks t = hbg->getTicks();
+    BOOST_CHECK_EQUAL( t, hbg->getTicks() );
+    hbg->enableSystemClock( true );
+    BOOST_CHECK( t <= hbg->getTicks() );
+
+    BOOST_CHECK( !hbg->enableFastClock( false ) );
+    BOOST_CHECK( !hbg->fastClockEnabled() );
+}
+
 BOOST_AUTO_TEST_CASE( testTimers )
 {
     TestTimer timer;
@@ -41,6 +41,7 @@ public:
     void testSecondsConversion();
     void testTicksConversion();
     void testTimeProgress();
+    void testFastClock();
     void testTimers();
     void testTimerPeriod();
 
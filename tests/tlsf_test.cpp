@@ -20,6 +20,10 @@
 
 #include "unit.hpp"
 #include <rtt/os/tlsf/tlsf.h>
+#include <rtt/os/oro_allocator.hpp>
+#include <rtt/rt_string.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_same.hpp>
 #include <signal.h>
 
 void signal_handler(int sig_num){
@@ -46,6 +50,31 @@ public:
     ~TLSFTest(){ tearDown(); };
 };
 
+#if TLSF_ARENAS
+#include <pthread.h>
+
+struct ArenaUser
+{
+    void* block;
+    void* pool;
+    size_t used;
+};
+
+/**
+ * Allocates in a new thread and leaves one block behind, which the
+ * creating thread frees.
+ */
+static void* allocateAndExit(void* arg)
+{
+    ArenaUser* u = (ArenaUser*) arg;
+    oro_rt_free( oro_rt_malloc(100) );
+    u->pool = get_arena_pool_self();
+    u->used = get_used_size(u->pool);
+    u->block = oro_rt_malloc(100);
+    return 0;
+}
+#endif
+
 BOOST_FIXTURE_TEST_SUITE(TLSFTestSuite, TLSFTest)
 
 BOOST_AUTO_TEST_CASE(testCreateAndDestroy)
@@ -92,6 +121,88 @@ BOOST_AUTO_TEST_CASE(testUseSecondaryMemPool){
     oro_rt_free(a);
 }
 
+#if TLSF_ARENAS
+BOOST_AUTO_TEST_CASE(testArenas)
+{
+    void* a = oro_rt_malloc(100);
+    BOOST_CHECK(a);
+    void* own = get_arena_pool_self();
+    BOOST_CHECK(own != rtMem);
+
+    // the block of the first thread is freed to its arena, which has no owner...
+    ArenaUser first = ArenaUser();
+    pthread_t t;
+    BOOST_REQUIRE_EQUAL(0, pthread_create(&t, 0, &allocateAndExit, &first));
+    pthread_join(t, 0);
+    BOOST_CHECK(first.block);
+    BOOST_CHECK(first.pool != own);
+    oro_rt_free(first.block);
+#if TLSF_STATISTIC
+    BOOST_CHECK_EQUAL(get_used_size(first.pool), first.used);
+#endif
+
+    // ...and the second thread adopts that arena.
+    ArenaUser second = ArenaUser();
+    BOOST_REQUIRE_EQUAL(0, pthread_create(&t, 0, &allocateAndExit, &second));
+    pthread_join(t, 0);
+    BOOST_CHECK_EQUAL(first.pool, second.pool);
+#if TLSF_STATISTIC
+    BOOST_CHECK_EQUAL(first.used, second.used);
+#endif
+    oro_rt_free(second.block);
+
+    unsigned int found = 0;
+    for (unsigned int i = 0; i != get_arena_count(); ++i)
+        if (get_arena_pool(i) == own || get_arena_pool(i) == first.pool)
+            ++found;
+    BOOST_CHECK_EQUAL(found, 2u);
+    oro_rt_free(a);
+}
+#endif
+
+#ifdef OS_RT_MALLOC_STATS
+BOOST_AUTO_TEST_CASE(testMemoryStatistics)
+{
+    using namespace RTT::os;
+    void* a = oro_rt_malloc(400);
+    BOOST_REQUIRE(a);
+    BOOST_CHECK_GE(getThreadMemoryUsage().blocks, 1u);
+    BOOST_CHECK_GE(getThreadMemoryUsage().bytes, 400u);
+    // with arenas, the default pool only holds the arena of this thread.
+    BOOST_CHECK_GE(getMemoryPoolUsage().blocks, 1u);
+    BOOST_CHECK_GE(getMemoryPoolUsage().peak, getMemoryPoolUsage().bytes);
+    oro_rt_free(a);
+}
+#endif
+
+#ifdef OS_RT_MALLOC_SUBSYSTEM_STATS
+BOOST_AUTO_TEST_CASE(testSubsystemMemoryStatistics)
+{
+    using namespace RTT::os;
+    MemoryUsage user = getSubsystemMemoryUsage(MemoryUser);
+    rt_subsystem_allocator<int, MemoryUser> alloc;
+
+    int* a = alloc.allocate(100);
+    MemoryUsage during = getSubsystemMemoryUsage(MemoryUser);
+    BOOST_CHECK_EQUAL(during.bytes, user.bytes + 100 * sizeof(int));
+    BOOST_CHECK_EQUAL(during.blocks, user.blocks + 1);
+    BOOST_CHECK_GE(during.peak, during.bytes);
+
+    alloc.deallocate(a, 100);
+    MemoryUsage after = getSubsystemMemoryUsage(MemoryUser);
+    BOOST_CHECK_EQUAL(after.bytes, user.bytes);
+    BOOST_CHECK_EQUAL(after.blocks, user.blocks);
+    BOOST_CHECK_EQUAL(after.peak, during.peak);
+
+    memoryAllocated(MemoryUser, 100, false);
+    BOOST_CHECK_EQUAL(getSubsystemMemoryUsage(MemoryUser).failures, user.failures + 1);
+    BOOST_CHECK_EQUAL(getSubsystemMemoryUsage(MemoryUser).bytes, user.bytes);
+}
+#else
+// without subsystem statistics, rt_string keeps its allocator type.
+BOOST_STATIC_ASSERT(( boost::is_same<RTT::rt_string::allocator_type, RTT::os::rt_allocator<char> >::value ));
+#endif
+
 BOOST_AUTO_TEST_CASE(testDoubleFree)
 {
     signal(SIGABRT,&signal_handler);
@@ -32,6 +32,7 @@
 #include <types/OperatorTypes.hpp>
 
 #include <types/SequenceTypeInfo.hpp>
+#include <types/PropertyDecomposition.hpp>
 
 struct TypekitFixture
 {
@@ -69,4 +70,32 @@ BOOST_AUTO_TEST_CASE( testComposeDecompose )
     }
 }
 
+//! The mqueue dispatcher settings of a ConnPolicy survive the typekit,
+//! as used by scripts and property files.
+BOOST_AUTO_TEST_CASE( testConnPolicyDispatcher )
+{
+    TypeInfo* ti = Types()->type("ConnPolicy");
+    BOOST_REQUIRE(ti);
+    ConnPolicy policy = ConnPolicy::buffer(10);
+    policy.dispatcher_scheduler = ORO_SCHED_OTHER;
+    policy.dispatcher_priority = 3;
+    policy.dispatcher_cpu_affinity = 0x2;
+    Property<ConnPolicy> input("A","B", policy);
+    Property<ConnPolicy> output("C","D");
+
+    DataSource<int>::shared_ptr priority = DataSource<int>::narrow( ti->getMember( input.getDataSource(), "dispatcher_priority" ).get() );
+    BOOST_REQUIRE( priority );
+    BOOST_CHECK_EQUAL( priority->get(), 3 );
+
+    PropertyBag bag;
+    BOOST_REQUIRE( typeDecomposition( input.getDataSource(), bag, false ) );
+    BOOST_CHECK( bag.getProperty("dispatcher_scheduler") );
+    BOOST_CHECK( bag.getProperty("dispatcher_cpu_affinity") );
+    BOOST_REQUIRE( ti->composeType( new ValueDataSource<PropertyBag>( bag ), output.getDataSource() ) );
+    BOOST_CHECK_EQUAL( output.value().size, 10 );
+    BOOST_CHECK_EQUAL( output.value().dispatcher_scheduler, ORO_SCHED_OTHER );
+    BOOST_CHECK_EQUAL( output.value().dispatcher_priority, 3 );
+    BOOST_CHECK_EQUAL( output.value().dispatcher_cpu_affinity, 0x2u );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
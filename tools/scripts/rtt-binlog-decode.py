@@ -0,0 +1,118 @@
+#!/usr/bin/env python
+#
+# Decodes a binary log file written by RTT::BinaryLogger into text,
+# one line per message:
+#
+#   <seconds since creation> [ Level  ][thread <id>] <formatted message>
+#
+# Usage: rtt-binlog-decode.py [--absolute] file.rtb
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+
+import re
+import struct
+import sys
+
+FILE_HEADER = struct.Struct('<8sIIIIq32x')
+RECORD_HEADER = struct.Struct('<IIqIBBH')
+
+LEVELS = ['', '[ FATAL  ]', '[CRITICAL]', '[ ERROR  ]', '[ Warning]',
+          '[ Info   ]', '[ Debug  ]', '[RealTime]']
+
+# printf conversions, of which the length modifiers are dropped.
+CONVERSION = re.compile(r'%([-+ #0]*\d*(?:\.\d+)?)(?:hh|h|ll|l|L|q|j|z|t)?([diouxXeEfFgGcsp%])')
+
+
+def to_python_format(fmt):
+    def convert(m):
+        flags, conv = m.group(1), m.group(2)
+        if conv == '%':
+            return '%%'
+        if conv in 'iu':
+            conv = 'd'
+        elif conv == 'p':
+            conv = 'x'
+        return '%' + flags + conv
+    return CONVERSION.sub(convert, fmt)
+
+
+def read_args(data, offset, nargs):
+    args = []
+    for _ in range(nargs):
+        tag = data[offset:offset + 1]
+        offset += 1
+        if tag == b'i':
+            args.append(struct.unpack_from('<q', data, offset)[0])
+            offset += 8
+        elif tag == b'u':
+            args.append(struct.unpack_from('<Q', data, offset)[0])
+            offset += 8
+        elif tag == b'd':
+            args.append(struct.unpack_from('<d', data, offset)[0])
+            offset += 8
+        elif tag == b's':
+            length = struct.unpack_from('<H', data, offset)[0]
+            offset += 2
+            args.append(data[offset:offset + length].decode('utf-8', 'replace'))
+            offset += length
+        else:
+            raise ValueError('unknown argument type %r' % tag)
+    return args
+
+
+def format_message(fmt, args):
+    try:
+        return to_python_format(fmt) % tuple(args)
+    except (TypeError, ValueError):
+        # wrong format string for these arguments: show them as-is.
+        return fmt + ' | ' + ', '.join(repr(a) for a in args)
+
+
+def decode(data, out, absolute=False):
+    magic, version, header_size, capacity, record_header_size, reference = \
+        FILE_HEADER.unpack_from(data, 0)
+    if magic != b'RTTBLOG\0' or version != 1:
+        raise ValueError('not an RTT binary log file (version 1)')
+    formats = {}
+    offset = header_size
+    messages = 0
+    while offset + record_header_size <= len(data):
+        size, committed, time, thread, rtype, nargs, rid = \
+            RECORD_HEADER.unpack_from(data, offset)
+        if size == 0:
+            break
+        payload = offset + record_header_size
+        if committed:
+            if rtype == 1:
+                level = data[payload] if isinstance(data[payload], int) else ord(data[payload])
+                end = data.index(b'\0', payload + 1)
+                formats[rid] = (level, data[payload + 1:end].decode('utf-8', 'replace'))
+            elif rtype == 2:
+                level, fmt = formats.get(rid, (0, '<unknown format %d>' % rid))
+                stamp = time if absolute else time - reference
+                out.write('%.6f %s[thread %d] %s\n' % (
+                    stamp / 1e9, LEVELS[level] if level < len(LEVELS) else '',
+                    thread, format_message(fmt, read_args(data, payload, nargs))))
+                messages += 1
+        offset += size
+    return messages
+
+
+def main(argv):
+    absolute = '--absolute' in argv
+    files = [a for a in argv[1:] if a != '--absolute']
+    if len(files) != 1:
+        sys.stderr.write('Usage: %s [--absolute] file.rtb\n' % argv[0])
+        return 1
+    with open(files[0], 'rb') as f:
+        data = f.read()
+    decode(data, sys.stdout, absolute)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))